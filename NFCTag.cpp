@@ -22,20 +22,24 @@
 #define GET_TAG_SIZE(uid_length) uid_length > 4 ? MIFARE_ULTRALIGHT_SIZE : MIFARE_CLASSIC_SIZE
 NFCTag::NFCTag(uint8_t *new_data, size_t uid_length)
 {
-    data = (uint8_t *)malloc(GET_TAG_SIZE(uid_length));
-    memcpy(data, new_data, GET_TAG_SIZE(uid_length));
+    data_size = GET_TAG_SIZE(uid_length);
+    data = (uint8_t *)malloc(data_size);
+    memcpy(data, new_data, data_size);
     uid = (uint8_t *)malloc(uid_length * sizeof(uint8_t));
     memcpy(uid, data, uid_length);
+    this->uid_length = uid_length;
     if (uid_length > 4)
         ultralight = true;
 }
 
 NFCTag::NFCTag(uint8_t *new_data, size_t uid_length, size_t pages)
 {
-    data = (uint8_t *)malloc(GET_TAG_SIZE(uid_length));
-    memcpy(data, new_data, GET_TAG_SIZE(uid_length));
+    data_size = pages * NTAG_PAGE_SIZE;
+    data = (uint8_t *)malloc(data_size);
+    memcpy(data, new_data, data_size);
     uid = (uint8_t *)malloc(uid_length * sizeof(uint8_t));
     memcpy(uid, data, uid_length);
+    this->uid_length = uid_length;
     ntag = true;
     pages_num = pages;
 }
@@ -43,9 +47,13 @@ NFCTag::NFCTag(uint8_t *new_data, size_t uid_length, size_t pages)
 NFCTag::NFCTag(uint8_t *idm, uint8_t *_pmm, uint16_t _sys_code)
 {
     uid = (uint8_t *)malloc(8 * sizeof(uint8_t));
+    pmm = (uint8_t *)malloc(8 * sizeof(uint8_t));
     memcpy(uid, idm, 8);
     memcpy(pmm, _pmm, 8);
+    uid_length = 8;
     sys_code = _sys_code;
+    data_size = FELICA_DUMP_BLOCKS * 16;
+    pages_num = FELICA_DUMP_BLOCKS;
     felica = true;
 }
 
@@ -55,21 +63,53 @@ NFCTag::NFCTag(uint8_t *idm, uint8_t *_pmm, uint16_t _sys_code, uint8_t data[14]
     pmm = (uint8_t *)malloc(8 * sizeof(uint8_t));
     memcpy(uid, idm, 8);
     memcpy(pmm, _pmm, 8);
+    uid_length = 8;
     sys_code = _sys_code;
+    data_size = FELICA_DUMP_BLOCKS * 16;
+    pages_num = FELICA_DUMP_BLOCKS;
     memcpy(felica_data, data, 14*16);
     // felica_blocks.insert(blocks->begin(), blocks->end());
     felica = true;
 }
 
+NFCTag::NFCTag(uint8_t *new_data, DumpPlan *plan)
+{
+    data = new_data;
+    data_size = dump_plan_image_size(plan);
+    uid = (uint8_t *)malloc(plan->uid_length * sizeof(uint8_t));
+    memcpy(uid, plan->uid, plan->uid_length);
+    uid_length = plan->uid_length;
+    planned = true;
+    atqa_value = plan->atqa;
+    sak_value = plan->sak;
+    name = plan->name;
+    ultralight = plan->family == CARD_MIFARE_ULTRALIGHT;
+    // Page based images have 4 bytes stride like NTAG
+    ntag = plan->family != CARD_MIFARE_CLASSIC;
+    pages_num = plan->blocks;
+}
 
 void NFCTag::get_block(int index, uint8_t *block)
 {
+    if (felica)
+    {
+        memcpy(block, felica_data[index], 16);
+        return;
+    }
     memcpy(block, &data[index * get_block_size()], sizeof(uint8_t) * get_block_size());
 }
 
 void NFCTag::get_atqa(uint8_t *atqa)
 {
-    memcpy(atqa, ultralight ? &data[9] : &data[7], sizeof(uint8_t) * 2);
+    if (planned)
+    {
+        atqa[0] = atqa_value >> 8;
+        atqa[1] = atqa_value;
+        return;
+    }
+    // Ultralight cards don't store it, they all answer 0x0044
+    atqa[0] = ultralight ? 0x00 : data[7];
+    atqa[1] = ultralight ? 0x44 : data[6];
 }
 
 uint8_t *NFCTag::get_data() {
@@ -77,7 +117,7 @@ uint8_t *NFCTag::get_data() {
         /* Flat FeliCa matrix data */
         uint8_t *flat_data = (uint8_t *)malloc(14*16);
         for(int i = 0; i < 14; i++) {
-            memcpy(&flat_data[i], &felica_data[i][0], 16);
+            memcpy(&flat_data[i * 16], &felica_data[i][0], 16);
         }
         return flat_data;
     }
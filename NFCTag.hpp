@@ -22,6 +22,8 @@
 #include <map>
 #include "nfc_framework.hpp"
 
+#define FELICA_DUMP_BLOCKS 14
+
 class NFCTag
 {
 private:
@@ -30,9 +32,16 @@ private:
     bool ntag = false;
     bool felica = false;
     uint8_t *uid;
+    size_t uid_length = 0;
     uint8_t *pmm;
     uint16_t sys_code;
-    size_t pages_num;
+    size_t pages_num = 0;   // Blocks/pages count when known from NTAG pages or dump plan
+    size_t data_size = 0;
+    // Anticollision data and name known only for dump plan images
+    bool planned = false;
+    uint16_t atqa_value = 0;
+    uint8_t sak_value = 0;
+    const char *name = NULL;
     /*  
         We can't take block position using array index 
         otherwise we would have enormous array with empty block
@@ -47,21 +56,34 @@ public:
     // Constructor for FeliCa
     NFCTag(uint8_t *idm, uint8_t *_pmm, uint16_t _sys_code);
     NFCTag(uint8_t *idm, uint8_t *_pmm, uint16_t _sys_code, uint8_t data[14][16]);
+    // Constructor for dump_tag(DumpPlan*) images, takes ownership of new_data without copying it
+    NFCTag(uint8_t *new_data, DumpPlan *plan);
     ~NFCTag(){};
     inline uint8_t *get_uid() { return uid; };
+    inline size_t get_uid_length() { return uid_length; };
+    inline uint8_t *get_pmm() { return pmm; };
+    inline uint16_t get_raw_sys_code() { return sys_code; };
+    inline const char *get_name() { return name; };
     uint8_t *get_data();
     void get_felica_data(uint8_t new_data[14][16]) { memcpy(new_data, felica_data, 14*16); };
-    inline size_t get_data_size() { return ultralight ? MIFARE_CLASSIC_SIZE : MIFARE_ULTRALIGHT_SIZE; };
+    inline size_t get_data_size() { return data_size; };
     inline bool is_ultralight() { return ultralight; };
     inline bool is_ntag() { return ntag; }
+    inline bool is_felica() { return felica; }
     void get_block(int index, uint8_t *block);
     inline size_t get_blocks_count() {
-        if(ntag)
+        if(pages_num)
             return pages_num;
         return ultralight ? MIFARE_ULTRALIGHT_BLOCKS : MIFARE_CLASSIC_BLOCKS;
     };
-    inline uint8_t get_bcc() { return ultralight ? 0 : data[5]; };
-    inline uint8_t get_sak() { return ultralight ? data[8] : data[6]; };
+    // Classic block 0: UID, BCC, SAK, ATQA(LSB first), manufacturer data
+    inline uint8_t get_bcc() { return ultralight ? 0 : data[4]; };
+    inline uint8_t get_sak() {
+        if(planned)
+            return sak_value;
+        return ultralight ? 0x00 : data[5];
+    };
+    // ATQA MSB first
     void get_atqa(uint8_t *atqa);
     FelicaSystemCodes get_sys_code();
 };
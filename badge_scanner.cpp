@@ -0,0 +1,136 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "badge_scanner.hpp"
+
+bool BadgeScanner::begin()
+{
+    /* MxRtyATR, MxRtyPSL, MxRtyPassiveActivation */
+    uint8_t cmd[] = {PN532_COMMAND_RFCONFIGURATION, RF_CONFIG_MAX_RETRIES, 0xFF, 0x01, config.retries};
+    uint8_t response[1];
+    for (size_t i = 0; i < BADGE_CACHE_SIZE; i++)
+        cache[i] = CachedBadge();
+    pending_first = 0;
+    pending_count = 0;
+    scans = 0;
+    window_scans = 0;
+    window_start = millis();
+    rate = 0;
+    return framework->pn532_command(cmd, sizeof(cmd), response, sizeof(response)) >= 0;
+}
+
+bool BadgeScanner::end()
+{
+    uint8_t cmd[] = {PN532_COMMAND_RFCONFIGURATION, RF_CONFIG_MAX_RETRIES, 0xFF, 0x01, RF_RETRIES_FOREVER};
+    uint8_t response[1];
+    return framework->pn532_command(cmd, sizeof(cmd), response, sizeof(response)) >= 0;
+}
+
+bool BadgeScanner::scan(uint8_t *uid, uint8_t *uid_length)
+{
+    uint8_t cmd[] = {PN532_COMMAND_INLISTPASSIVETARGET, 1, PN532_MIFARE_ISO14443A};
+    uint8_t response[20];
+
+    /* NbTg, Tg, SENS_RES(2 bytes), SEL_RES, NFCID1 length, NFCID1 */
+    int16_t len = framework->pn532_command(cmd, sizeof(cmd), response, sizeof(response), config.poll_timeout);
+    if (len < 6 || response[0] != 1 || response[5] > 7 || len < 6 + response[5])
+        return false;
+    *uid_length = response[5];
+    memcpy(uid, &response[6], *uid_length);
+    return true;
+}
+
+void BadgeScanner::push_event(CachedBadge *badge, PresenceEventType type, unsigned long now)
+{
+    // One scan never queues more than BADGE_PENDING_SIZE events and starts on an empty ring
+    PresenceEvent *event = &pending[(pending_first + pending_count++) % BADGE_PENDING_SIZE];
+    *event = PresenceEvent();
+    event->type = type;
+    event->card_type = AUTOPOLL_GENERIC_106;
+    event->uid_length = badge->uid_length;
+    memcpy(event->uid, badge->uid, badge->uid_length);
+    event->timestamp = now;
+}
+
+size_t BadgeScanner::poll(PresenceEvent *events, size_t max_events)
+{
+    size_t count = 0;
+    if (pending_count == 0)
+        update();
+    while (count < max_events && pending_count > 0)
+    {
+        events[count++] = pending[pending_first];
+        pending_first = (pending_first + 1) % BADGE_PENDING_SIZE;
+        pending_count--;
+    }
+    return count;
+}
+
+void BadgeScanner::update()
+{
+    uint8_t uid[7];
+    uint8_t uid_length = 0;
+    bool found = scan(uid, &uid_length);
+    unsigned long now = millis();
+
+    scans++;
+    window_scans++;
+    if (now - window_start >= 1000)
+    {
+        rate = window_scans * 1000.0f / (now - window_start);
+        window_scans = 0;
+        window_start = now;
+    }
+
+    CachedBadge *slot = NULL;
+    CachedBadge *oldest = NULL;
+    for (size_t i = 0; i < BADGE_CACHE_SIZE; i++)
+    {
+        CachedBadge *badge = &cache[i];
+        if (badge->used && found && badge->uid_length == uid_length && memcmp(badge->uid, uid, uid_length) == 0)
+        {
+            // Still in the field, nothing to report
+            badge->last_seen = now;
+            found = false;
+            continue;
+        }
+        if (badge->used && now - badge->last_seen > config.window)
+        {
+            push_event(badge, PRESENCE_REMOVED, now);
+            badge->used = false;
+        }
+        if (!badge->used && slot == NULL)
+            slot = badge;
+        if (badge->used && (oldest == NULL || badge->last_seen < oldest->last_seen))
+            oldest = badge;
+    }
+
+    if (!found)
+        return;
+
+    /* New badge, make room for it dropping the one unseen for longer */
+    if (slot == NULL)
+    {
+        push_event(oldest, PRESENCE_REMOVED, now);
+        slot = oldest;
+    }
+    slot->used = true;
+    slot->uid_length = uid_length;
+    memcpy(slot->uid, uid, uid_length);
+    slot->last_seen = now;
+    push_event(slot, PRESENCE_ARRIVED, now);
+}
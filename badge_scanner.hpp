@@ -0,0 +1,88 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BADGE_SCANNER_H
+#define BADGE_SCANNER_H
+
+#include "nfc_framework.hpp"
+
+#define BADGE_CACHE_SIZE 8              // Badges tracked at the same time
+#define BADGE_PENDING_SIZE (BADGE_CACHE_SIZE + 1)   // Events of one scan: every departure and an arrival
+#define RF_CONFIG_MAX_RETRIES 0x05      // RFConfiguration item
+#define RF_RETRIES_FOREVER 0xFF
+
+typedef struct BadgeScannerConfig {
+    uint8_t retries = 0x00;         // MxRtyPassiveActivation, 0x00 is a single activation attempt
+    uint16_t poll_timeout = 30;     // ms waited for each InListPassiveTarget answer
+    uint16_t window = 250;          // ms a badge can go unseen before its departure
+} BadgeScannerConfig;
+
+/*
+    Continuous ISO14443A badge scanning for gates and turnstiles.
+    PN532 gives up after the configured activation retries so every
+    poll is a few ms long, and a cache of the badges seen in the last
+    window turns repeated reads into one arrival and one departure.
+*/
+class BadgeScanner
+{
+private:
+    typedef struct CachedBadge {
+        bool used = false;
+        uint8_t uid[7] = {0};
+        uint8_t uid_length = 0;
+        unsigned long last_seen = 0;
+    } CachedBadge;
+
+    NFCFramework *framework;
+    BadgeScannerConfig config;
+    CachedBadge cache[BADGE_CACHE_SIZE];
+    // Ring of events not delivered yet
+    PresenceEvent pending[BADGE_PENDING_SIZE];
+    size_t pending_first = 0;
+    size_t pending_count = 0;
+
+    uint32_t scans = 0;
+    uint32_t window_scans = 0;
+    unsigned long window_start = 0;
+    float rate = 0;
+
+    bool scan(uint8_t *uid, uint8_t *uid_length);
+    // Scan once and queue arrival/departure events in pending
+    void update();
+    void push_event(CachedBadge *badge, PresenceEventType type, unsigned long now);
+public:
+    BadgeScanner(NFCFramework *_framework, BadgeScannerConfig _config = BadgeScannerConfig()) {
+        framework = _framework;
+        config = _config;
+    };
+    // Program PN532 retries, call it again after a power down
+    bool begin();
+    // Give back the default infinite retries to the framework
+    bool end();
+    /*
+        Scan once and put arrival/departure events in events.
+        Return the number of events, 0 while the same badges stay in the field.
+        Events past max_events are returned by the next calls, which scan again
+        only once they are all delivered
+    */
+    size_t poll(PresenceEvent *events, size_t max_events);
+    // Scans per second measured over the last second
+    inline float get_scan_rate() { return rate; };
+    inline uint32_t get_scans() { return scans; };
+};
+
+#endif
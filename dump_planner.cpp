@@ -0,0 +1,150 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "dump_planner.hpp"
+
+static void plan_classic(DumpPlan *plan, const char *name, uint8_t sectors)
+{
+    plan->name = name;
+    plan->family = CARD_MIFARE_CLASSIC;
+    plan->sectors = sectors;
+    plan->blocks = classic_first_block(sectors);
+    plan->unit_size = 16;
+    plan->units_per_read = 1;
+    plan->read_command = 0x30;    // READ
+}
+
+void dump_plan_pages(DumpPlan *plan, const char *name, CardFamily family, uint16_t pages)
+{
+    plan->name = name;
+    plan->family = family;
+    plan->sectors = 0;
+    plan->blocks = pages;
+    plan->unit_size = 4;
+    plan->units_per_read = 4;
+    plan->read_command = 0x30;    // READ
+    plan->hidden_units = 0;
+}
+
+bool dump_plan_classic_blocks(DumpPlan *plan, uint16_t blocks)
+{
+    switch (blocks)
+    {
+    case 20:
+        plan_classic(plan, "Mifare Mini", 5);
+        return true;
+    case 64:
+        plan_classic(plan, "Mifare Classic 1K", 16);
+        return true;
+    case 128:
+        plan_classic(plan, "Mifare Classic 2K", 32);
+        return true;
+    case 256:
+        plan_classic(plan, "Mifare Classic 4K", 40);
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool dump_plan_build(uint16_t atqa, uint8_t sak, uint8_t *uid, uint8_t uid_length, uint8_t *version, DumpPlan *plan)
+{
+    *plan = DumpPlan();
+    plan->atqa = atqa;
+    plan->sak = sak;
+    plan->uid_length = uid_length > sizeof(plan->uid) ? sizeof(plan->uid) : uid_length;
+    memcpy(plan->uid, uid, plan->uid_length);
+
+    switch (sak)
+    {
+    case 0x09:
+        plan_classic(plan, "Mifare Mini", 5);
+        return true;
+    case 0x08:
+    case 0x28:
+    case 0x88:
+        plan_classic(plan, "Mifare Classic 1K", 16);
+        return true;
+    case 0x19:
+        plan_classic(plan, "Mifare Classic 2K", 32);
+        return true;
+    case 0x18:
+    case 0x38:
+        plan_classic(plan, "Mifare Classic 4K", 40);
+        return true;
+    case 0x00:
+        break;
+    default:
+        return false;
+    }
+
+    if (uid_length != 7)
+        return false;
+
+    if (version == NULL)
+    {
+        // Original Ultralight doesn't know GET_VERSION
+        dump_plan_pages(plan, "Mifare Ultralight", CARD_MIFARE_ULTRALIGHT, 16);
+        return true;
+    }
+
+    /* GET_VERSION: header, vendor, product type, subtype, major, minor, storage size, protocol */
+    uint8_t storage = version[6];
+    if (version[2] == GET_VERSION_NTAG)
+    {
+        switch (storage)
+        {
+        case 0x0B:
+            dump_plan_pages(plan, "NTAG210", CARD_NTAG, 20);
+            return true;
+        case 0x0E:
+            dump_plan_pages(plan, "NTAG212", CARD_NTAG, 41);
+            return true;
+        case 0x0F:
+            dump_plan_pages(plan, "NTAG213", CARD_NTAG, 45);
+            return true;
+        case 0x11:
+            dump_plan_pages(plan, "NTAG215", CARD_NTAG, 135);
+            return true;
+        case 0x13:
+            dump_plan_pages(plan, "NTAG216", CARD_NTAG, 231);
+            return true;
+        }
+    }
+    else if (version[2] == GET_VERSION_ULTRALIGHT)
+    {
+        switch (storage)
+        {
+        case 0x0B:
+            dump_plan_pages(plan, "Mifare Ultralight EV1 MF0UL11", CARD_MIFARE_ULTRALIGHT, 20);
+            return true;
+        case 0x0E:
+            dump_plan_pages(plan, "Mifare Ultralight EV1 MF0UL21", CARD_MIFARE_ULTRALIGHT, 41);
+            return true;
+        }
+    }
+
+    /* Unknown Type 2 tag, storage size is 2^(n/2) bytes of user memory(rounded down) plus 4 header pages */
+    if (storage < TYPE2_MIN_STORAGE || storage > TYPE2_MAX_STORAGE)
+        return false;
+    uint16_t pages = 4 + (1 << (storage >> 1)) / 4;
+    if (pages > TYPE2_MAX_PAGES)
+        return false;
+    dump_plan_pages(plan, "Type 2 tag", CARD_NTAG, pages);
+    return true;
+}
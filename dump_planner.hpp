@@ -0,0 +1,88 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DUMP_PLANNER_H
+#define DUMP_PLANNER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define GET_VERSION_CMD 0x60
+#define GET_VERSION_SIZE 8
+#define GET_VERSION_ULTRALIGHT 0x03     // Product type
+#define GET_VERSION_NTAG 0x04
+#define TYPE2_READ_SIZE 16              // READ always returns 16 bytes
+#define ULTRALIGHT_C_AUTH_CMD 0x1A
+#define ULTRALIGHT_C_PAGES 48           // Image size, the last four pages hold the 3DES key and read as NAK
+#define ULTRALIGHT_C_KEY_PAGES 4
+#define TYPE2_MIN_STORAGE 0x0B          // GET_VERSION storage sizes in NTAG/Ultralight EV1/NTAG I2C datasheets
+#define TYPE2_MAX_STORAGE 0x15
+#define TYPE2_MAX_PAGES 256             // READ/WRITE page address, larger tags need SECTOR_SELECT
+#define MIFARE_CLASSIC_4K_SMALL_SECTORS 32   // Sectors with 4 blocks in a 4K card
+
+typedef enum CardFamily {
+    CARD_UNKNOWN,
+    CARD_MIFARE_CLASSIC,
+    CARD_MIFARE_ULTRALIGHT,
+    CARD_NTAG
+} CardFamily;
+
+/*
+    Exact read plan for an identified ISO14443A tag.
+    Classic cards are read one 16 bytes block per READ after a sector
+    authentication, Ultralight/NTAG cards four 4 bytes pages per READ.
+*/
+typedef struct DumpPlan {
+    const char *name = "Unknown";
+    CardFamily family = CARD_UNKNOWN;
+    uint16_t blocks = 0;        // Blocks for Classic, pages for Ultralight/NTAG
+    uint8_t unit_size = 0;      // Bytes per block/page in the image
+    uint8_t units_per_read = 0; // Blocks/pages returned by read_command
+    uint8_t read_command = 0;
+    uint8_t hidden_units = 0;   // Last pages the card never returns(Ultralight C key), zero in the image
+    uint8_t sectors = 0;        // Classic only
+    uint8_t uid[7] = {0};
+    uint8_t uid_length = 0;
+    uint16_t atqa = 0;
+    uint8_t sak = 0;
+} DumpPlan;
+
+/*
+    Build plan from anticollision data and GET_VERSION response(NULL if
+    the card doesn't answer to it, that is taken as an original Ultralight:
+    Ultralight C needs an AUTHENTICATE probe on the card to be told apart).
+    Return false for unsupported cards.
+*/
+bool dump_plan_build(uint16_t atqa, uint8_t sak, uint8_t *uid, uint8_t uid_length, uint8_t *version, DumpPlan *plan);
+
+// Fill plan geometry for an image whose type is already known(e.g. loaded from file)
+bool dump_plan_classic_blocks(DumpPlan *plan, uint16_t blocks);
+void dump_plan_pages(DumpPlan *plan, const char *name, CardFamily family, uint16_t pages);
+
+inline size_t dump_plan_image_size(const DumpPlan *plan) { return (size_t)plan->blocks * plan->unit_size; };
+
+// Mifare Classic geometry(4K cards have 8 sectors of 16 blocks after sector 31)
+inline uint8_t classic_sector_of(uint16_t block) {
+    return block < MIFARE_CLASSIC_4K_SMALL_SECTORS * 4 ? block / 4 : MIFARE_CLASSIC_4K_SMALL_SECTORS + (block - MIFARE_CLASSIC_4K_SMALL_SECTORS * 4) / 16;
+};
+inline uint16_t classic_first_block(uint8_t sector) {
+    return sector < MIFARE_CLASSIC_4K_SMALL_SECTORS ? sector * 4 : MIFARE_CLASSIC_4K_SMALL_SECTORS * 4 + (sector - MIFARE_CLASSIC_4K_SMALL_SECTORS) * 16;
+};
+inline uint8_t classic_sector_blocks(uint8_t sector) { return sector < MIFARE_CLASSIC_4K_SMALL_SECTORS ? 4 : 16; };
+inline uint16_t classic_trailer_block(uint8_t sector) { return classic_first_block(sector) + classic_sector_blocks(sector) - 1; };
+
+#endif
@@ -0,0 +1,544 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dump_store.hpp"
+#include "nfc_export.hpp"
+
+static const char *const store_types[] = {"classic", "ultralight", "ntag", "felica"};
+#define STORE_TYPES (sizeof(store_types) / sizeof(store_types[0]))
+
+static uint32_t fnv1a(const uint8_t *data, size_t len)
+{
+    uint32_t hash = 0x811C9DC5;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= data[i];
+        hash *= 0x01000193;
+    }
+    return hash;
+}
+
+static void put_le32(uint32_t value, uint8_t *out)
+{
+    out[0] = value;
+    out[1] = value >> 8;
+    out[2] = value >> 16;
+    out[3] = value >> 24;
+}
+
+static uint32_t get_le32(const uint8_t *in)
+{
+    return in[0] | (in[1] << 8) | (in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+/* Cut the export_mfd image in chunks and write their pool indexes to the record */
+class DumpChunkWriter : public Print
+{
+private:
+    DumpStore *store;
+    fs::File *record;
+    uint8_t chunk[DUMP_STORE_CHUNK];
+    size_t used = 0;
+public:
+    bool failed = false;
+    std::vector<uint32_t> chunks;   // Referenced so far, released if the save fails
+
+    DumpChunkWriter(DumpStore *_store, fs::File *_record) {
+        store = _store;
+        record = _record;
+    };
+    size_t write(uint8_t c) {
+        chunk[used++] = c;
+        if (used == DUMP_STORE_CHUNK)
+            flush_chunk();
+        return 1;
+    };
+    void flush_chunk() {
+        if (used == 0)
+            return;
+        memset(&chunk[used], 0, DUMP_STORE_CHUNK - used);
+        used = 0;
+        uint8_t index[4];
+        int32_t position = store->store_chunk(chunk);
+        if (position >= 0)
+            chunks.push_back(position);
+        put_le32(position, index);
+        if (position < 0 || record->write(index, sizeof(index)) != sizeof(index))
+            failed = true;
+    };
+};
+
+bool DumpStore::begin()
+{
+    char path[DUMP_STORE_PATH_MAX];
+    if (!fs->exists(root) && !fs->mkdir(root))
+        return false;
+    snprintf(path, sizeof(path), "%s/h", root);
+    if (!fs->exists(path) && !fs->mkdir(path))
+        return false;
+    snprintf(path, sizeof(path), "%s/u", root);
+    if (!fs->exists(path) && !fs->mkdir(path))
+        return false;
+
+    /* Pool is kept open, chunks are appended and compared in place */
+    snprintf(path, sizeof(path), "%s/blocks.bin", root);
+    pool = fs->open(path, fs->exists(path) ? "r+" : "w+");
+    snprintf(path, sizeof(path), "%s/refs.bin", root);
+    bool counted = fs->exists(path);
+    refs_file = fs->open(path, counted ? "r+" : "w+");
+    if (!pool || !refs_file)
+    {
+        LOG_ERROR("Unable to open dump store pool\n");
+        end();
+        return false;
+    }
+
+    /* Chunks saved before the counts were kept may be used by any record, they stay */
+    uint8_t count[2];
+    size_t known = 0;
+    refs.assign(pool.size() / DUMP_STORE_CHUNK, DUMP_STORE_PINNED);
+    while (counted && known < refs.size() && refs_file.read(count, sizeof(count)) == sizeof(count))
+    {
+        refs[known++] = count[0] | (count[1] << 8);
+    }
+    refs_first = known;
+    refs_last = refs.size();
+    free_hint = 0;
+    pending.clear();
+    return commit();
+}
+
+void DumpStore::end()
+{
+    if (pool)
+        pool.close();
+    if (refs_file)
+        refs_file.close();
+    refs.clear();
+}
+
+size_t DumpStore::pool_chunks()
+{
+    return pool ? pool.size() / DUMP_STORE_CHUNK : 0;
+}
+
+size_t DumpStore::used_chunks()
+{
+    size_t used = 0;
+    for (size_t i = 0; i < refs.size(); i++)
+    {
+        if (refs[i] != 0)
+            used++;
+    }
+    return used;
+}
+
+void DumpStore::record_path(const uint8_t *uid, uint8_t uid_length, const char *type, char *path)
+{
+    size_t len = snprintf(path, DUMP_STORE_PATH_MAX, "%s/u/", root);
+    for (uint8_t i = 0; i < uid_length && len + 3 < DUMP_STORE_PATH_MAX; i++)
+        len += snprintf(&path[len], DUMP_STORE_PATH_MAX - len, "%02X", uid[i]);
+    snprintf(&path[len], DUMP_STORE_PATH_MAX - len, ".%s", type);
+}
+
+bool DumpStore::find_chunk(const uint8_t *chunk, uint32_t hash, uint32_t *index)
+{
+    char path[DUMP_STORE_PATH_MAX];
+    uint8_t entry[8];
+    uint8_t stored[DUMP_STORE_CHUNK];
+    // Same hash is checked against the pool bytes, a reused slot may hold another chunk now
+    auto same = [&](uint32_t candidate) {
+        return candidate < refs.size() && pool.seek(candidate * DUMP_STORE_CHUNK) &&
+               pool.read(stored, DUMP_STORE_CHUNK) == DUMP_STORE_CHUNK && memcmp(stored, chunk, DUMP_STORE_CHUNK) == 0;
+    };
+
+    /* Chunks of the save in progress aren't in the buckets yet */
+    for (size_t i = 0; i < pending.size(); i += 2)
+    {
+        if (pending[i] == hash && same(pending[i + 1]))
+        {
+            *index = pending[i + 1];
+            return true;
+        }
+    }
+
+    snprintf(path, sizeof(path), "%s/h/%02X", root, (unsigned)(hash & 0xFF));
+    if (!fs->exists(path))
+        return false;
+    /* Bucket entries: hash, chunk index */
+    fs::File bucket = fs->open(path, FILE_READ);
+    while (bucket && bucket.read(entry, sizeof(entry)) == sizeof(entry))
+    {
+        if (get_le32(entry) == hash && same(get_le32(&entry[4])))
+        {
+            *index = get_le32(&entry[4]);
+            bucket.close();
+            return true;
+        }
+    }
+    bucket.close();
+    return false;
+}
+
+int32_t DumpStore::store_chunk(const uint8_t *chunk)
+{
+    uint32_t hash = fnv1a(chunk, DUMP_STORE_CHUNK);
+    uint32_t index;
+    if (!find_chunk(chunk, hash, &index))
+    {
+        /* First free slot, or a new one at the end of the pool */
+        while (free_hint < refs.size() && refs[free_hint] != 0)
+        {
+            free_hint++;
+        }
+        index = free_hint;
+        if (!pool.seek(index * DUMP_STORE_CHUNK) || pool.write(chunk, DUMP_STORE_CHUNK) != DUMP_STORE_CHUNK)
+            return -1;
+        if (index == refs.size())
+            refs.push_back(0);
+        pending.push_back(hash);
+        pending.push_back(index);
+    }
+    add_ref(index, 1);
+    return index;
+}
+
+void DumpStore::add_ref(uint32_t index, int delta)
+{
+    if (index >= refs.size() || refs[index] == DUMP_STORE_PINNED || (delta < 0 && refs[index] == 0))
+        return;
+    refs[index] += delta;
+    uint32_t hash;
+    if (refs[index] == 0 && slot_hash(index, &hash))
+        stale_buckets[(hash & 0xFF) / 8] |= 1 << (hash & 7);
+    if (refs[index] == 0 && index < free_hint)
+        free_hint = index;
+    if (refs_first == refs_last)
+    {
+        refs_first = index;
+        refs_last = index + 1;
+    }
+    else
+    {
+        refs_first = index < refs_first ? index : refs_first;
+        refs_last = index + 1 > refs_last ? index + 1 : refs_last;
+    }
+}
+
+bool DumpStore::slot_hash(uint32_t index, uint32_t *hash)
+{
+    uint8_t stored[DUMP_STORE_CHUNK];
+    if (!pool.seek(index * DUMP_STORE_CHUNK) || pool.read(stored, DUMP_STORE_CHUNK) != DUMP_STORE_CHUNK)
+        return false;
+    *hash = fnv1a(stored, DUMP_STORE_CHUNK);
+    return true;
+}
+
+bool DumpStore::compact_bucket(uint8_t id)
+{
+    char path[DUMP_STORE_PATH_MAX];
+    uint8_t entry[8];
+    std::vector<uint32_t> live;
+    snprintf(path, sizeof(path), "%s/h/%02X", root, id);
+
+    /* Keep entries of used chunks still holding the same bytes, once each */
+    fs::File bucket = fs->open(path, FILE_READ);
+    while (bucket && bucket.read(entry, sizeof(entry)) == sizeof(entry))
+    {
+        uint32_t hash = get_le32(entry);
+        uint32_t index = get_le32(&entry[4]);
+        uint32_t stored;
+        bool kept = false;
+        for (size_t i = 1; i < live.size() && !kept; i += 2)
+            kept = live[i] == index;
+        if (!kept && index < refs.size() && refs[index] != 0 && slot_hash(index, &stored) && stored == hash)
+        {
+            live.push_back(hash);
+            live.push_back(index);
+        }
+    }
+    if (bucket)
+        bucket.close();
+    for (size_t i = 0; i < pending.size(); i += 2)
+    {
+        if ((pending[i] & 0xFF) == id)
+        {
+            live.push_back(pending[i]);
+            live.push_back(pending[i + 1]);
+        }
+    }
+
+    if (live.empty())
+        return !fs->exists(path) || fs->remove(path);
+    bool success = true;
+    bucket = fs->open(path, FILE_WRITE);
+    if (!bucket)
+        return false;
+    for (size_t i = 0; i < live.size(); i += 2)
+    {
+        put_le32(live[i], entry);
+        put_le32(live[i + 1], &entry[4]);
+        success = bucket.write(entry, sizeof(entry)) == sizeof(entry) && success;
+    }
+    bucket.close();
+    return success;
+}
+
+bool DumpStore::record_chunks(const char *path, std::vector<uint32_t> *chunks)
+{
+    uint8_t index[4];
+    fs::File record = fs->open(path, FILE_READ);
+    if (!record || !record.seek(DUMP_STORE_HEADER_SIZE))
+        return false;
+    while (record.read(index, sizeof(index)) == sizeof(index))
+    {
+        chunks->push_back(get_le32(index));
+    }
+    record.close();
+    return true;
+}
+
+bool DumpStore::commit()
+{
+    char path[DUMP_STORE_PATH_MAX];
+    uint8_t entry[8];
+    bool success = true;
+    pool.flush();
+
+    /* Buckets with freed chunks are rewritten, the others get the new entries appended */
+    for (uint16_t id = 0; id <= 0xFF; id++)
+    {
+        if (stale_buckets[id / 8] & (1 << (id & 7)))
+        {
+            success = compact_bucket(id) && success;
+            continue;
+        }
+        fs::File bucket;
+        for (size_t i = 0; i < pending.size(); i += 2)
+        {
+            if ((pending[i] & 0xFF) != id)
+                continue;
+            if (!bucket)
+            {
+                snprintf(path, sizeof(path), "%s/h/%02X", root, id);
+                bucket = fs->open(path, FILE_APPEND);
+            }
+            put_le32(pending[i], entry);
+            put_le32(pending[i + 1], &entry[4]);
+            success = bucket.write(entry, sizeof(entry)) == sizeof(entry) && success;
+        }
+        if (bucket)
+            bucket.close();
+    }
+    pending.clear();
+    memset(stale_buckets, 0, sizeof(stale_buckets));
+
+    if (refs_first < refs_last)
+    {
+        uint8_t count[2];
+        success = refs_file.seek(refs_first * sizeof(count)) && success;
+        for (size_t i = refs_first; i < refs_last; i++)
+        {
+            count[0] = refs[i];
+            count[1] = refs[i] >> 8;
+            success = refs_file.write(count, sizeof(count)) == sizeof(count) && success;
+        }
+        refs_file.flush();
+        refs_first = refs_last = 0;
+    }
+    if (!success)
+        LOG_ERROR("Unable to update dump store index\n");
+    return success;
+}
+
+bool DumpStore::save(NFCTag *tag)
+{
+    char path[DUMP_STORE_PATH_MAX];
+    uint8_t header[DUMP_STORE_HEADER_SIZE] = {'N', 'F', 'C', 'D', DUMP_STORE_VERSION};
+    const char *type = export_type_name(tag);
+    if (!pool)
+        return false;
+
+    /* Header: magic, version, type, UID length, SAK, ATQA, UID, PMm, system code, blocks/pages */
+    for (uint8_t i = 0; i < STORE_TYPES; i++)
+    {
+        if (strcmp(type, store_types[i]) == 0)
+            header[5] = i;
+    }
+    header[6] = tag->get_uid_length() > 8 ? 8 : tag->get_uid_length();
+    memcpy(&header[10], tag->get_uid(), header[6]);
+    if (tag->is_felica())
+    {
+        memcpy(&header[18], tag->get_pmm(), 8);
+        header[26] = tag->get_raw_sys_code() >> 8;
+        header[27] = tag->get_raw_sys_code();
+    }
+    else
+    {
+        // MSB first for legacy and planned tags alike
+        tag->get_atqa(&header[8]);
+        header[7] = tag->get_sak();
+    }
+    header[28] = tag->get_blocks_count();
+    header[29] = tag->get_blocks_count() >> 8;
+
+    record_path(tag->get_uid(), header[6], type, path);
+    std::vector<uint32_t> previous;
+    if (fs->exists(path))
+        record_chunks(path, &previous);
+    fs::File record = fs->open(path, FILE_WRITE);
+    if (!record)
+    {
+        LOG_ERROR("Unable to write dump record\n");
+        return false;
+    }
+    DumpChunkWriter writer(this, &record);
+    bool success = record.write(header, sizeof(header)) == sizeof(header);
+    if (success)
+    {
+        export_mfd(tag, &writer);
+        writer.flush_chunk();
+        success = !writer.failed;
+    }
+    record.close();
+
+    /* The previous dump is overwritten either way, its chunks are released after the new ones are taken */
+    for (size_t i = 0; i < previous.size(); i++)
+    {
+        add_ref(previous[i], -1);
+    }
+    if (!success)
+    {
+        LOG_ERROR("Unable to write dump record\n");
+        fs->remove(path);
+        for (size_t i = 0; i < writer.chunks.size(); i++)
+        {
+            add_ref(writer.chunks[i], -1);
+        }
+    }
+    return commit() && success;
+}
+
+NFCTag *DumpStore::load_record(fs::File *record)
+{
+    uint8_t header[DUMP_STORE_HEADER_SIZE];
+    uint8_t index[4];
+    if (record->read(header, sizeof(header)) != sizeof(header) || memcmp(header, "NFCD", 4) != 0 ||
+        header[4] != DUMP_STORE_VERSION || header[5] >= STORE_TYPES)
+        return NULL;
+
+    bool felica = header[5] == 3;
+    bool paged = header[5] == 1 || header[5] == 2;
+    uint16_t units = header[28] | (header[29] << 8);
+    size_t size = (size_t)units * (paged ? NTAG_PAGE_SIZE : BLOCK_SIZE);
+    size_t chunks = (size + DUMP_STORE_CHUNK - 1) / DUMP_STORE_CHUNK;
+    if (felica && units != FELICA_DUMP_BLOCKS)
+        return NULL;
+
+    uint8_t *image = (uint8_t *)malloc(chunks * DUMP_STORE_CHUNK);
+    if (image == NULL)
+        return NULL;
+    for (size_t i = 0; i < chunks; i++)
+    {
+        uint8_t *chunk = &image[i * DUMP_STORE_CHUNK];
+        if (record->read(index, sizeof(index)) != sizeof(index) ||
+            !pool.seek(get_le32(index) * DUMP_STORE_CHUNK) || pool.read(chunk, DUMP_STORE_CHUNK) != DUMP_STORE_CHUNK)
+        {
+            free(image);
+            return NULL;
+        }
+    }
+
+    if (felica)
+    {
+        uint8_t blocks[FELICA_DUMP_BLOCKS][16];
+        memcpy(blocks, image, sizeof(blocks));
+        free(image);
+        return new NFCTag(&header[10], &header[18], (header[26] << 8) | header[27], blocks);
+    }
+
+    DumpPlan plan;
+    if (paged)
+    {
+        dump_plan_pages(&plan, header[5] == 2 ? "NTAG" : "Mifare Ultralight", header[5] == 2 ? CARD_NTAG : CARD_MIFARE_ULTRALIGHT, units);
+    }
+    else if (!dump_plan_classic_blocks(&plan, units))
+    {
+        free(image);
+        return NULL;
+    }
+    plan.uid_length = header[6] > sizeof(plan.uid) ? sizeof(plan.uid) : header[6];
+    memcpy(plan.uid, &header[10], plan.uid_length);
+    plan.atqa = (header[8] << 8) | header[9];
+    plan.sak = header[7];
+    return new NFCTag(image, &plan);
+}
+
+NFCTag *DumpStore::load(const uint8_t *uid, uint8_t uid_length, const char *type)
+{
+    char path[DUMP_STORE_PATH_MAX];
+    if (!pool)
+        return NULL;
+    for (uint8_t i = 0; i < STORE_TYPES; i++)
+    {
+        if (type != NULL && strcmp(type, store_types[i]) != 0)
+            continue;
+        record_path(uid, uid_length, store_types[i], path);
+        if (!fs->exists(path))
+            continue;
+        fs::File record = fs->open(path, FILE_READ);
+        NFCTag *tag = record ? load_record(&record) : NULL;
+        record.close();
+        return tag;
+    }
+    return NULL;
+}
+
+bool DumpStore::contains(const uint8_t *uid, uint8_t uid_length, const char *type)
+{
+    char path[DUMP_STORE_PATH_MAX];
+    for (uint8_t i = 0; i < STORE_TYPES; i++)
+    {
+        if (type != NULL && strcmp(type, store_types[i]) != 0)
+            continue;
+        record_path(uid, uid_length, store_types[i], path);
+        if (fs->exists(path))
+            return true;
+    }
+    return false;
+}
+
+bool DumpStore::remove(const uint8_t *uid, uint8_t uid_length, const char *type)
+{
+    char path[DUMP_STORE_PATH_MAX];
+    bool removed = false;
+    for (uint8_t i = 0; i < STORE_TYPES; i++)
+    {
+        if (type != NULL && strcmp(type, store_types[i]) != 0)
+            continue;
+        record_path(uid, uid_length, store_types[i], path);
+        std::vector<uint32_t> chunks;
+        if (!fs->exists(path) || !record_chunks(path, &chunks) || !fs->remove(path))
+            continue;
+        for (size_t j = 0; j < chunks.size(); j++)
+        {
+            add_ref(chunks[j], -1);
+        }
+        removed = true;
+    }
+    return commit() && removed;
+}
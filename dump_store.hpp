@@ -0,0 +1,97 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DUMP_STORE_H
+#define DUMP_STORE_H
+
+#include <FS.h>
+#include <vector>
+#include "NFCTag.hpp"
+
+#define DUMP_STORE_CHUNK 16             // Deduplicated unit, one Classic/FeliCa block or four pages
+#define DUMP_STORE_HEADER_SIZE 32
+#define DUMP_STORE_VERSION 1
+#define DUMP_STORE_PATH_MAX 64
+#define DUMP_STORE_PINNED 0xFFFF        // Reference count of chunks saved before counts were kept, never freed
+
+/*
+    Persistent dump store on any fs::FS(LittleFS, SD, ...).
+    Layout under root:
+      blocks.bin     every distinct 16 bytes chunk, stored once
+      refs.bin       records using each chunk, 16 bits LSB first
+      h/XX           hash buckets: FNV-1a hash and chunk index of the
+                     chunks whose hash ends with XX
+      u/UID.type     one record per card: header and chunk indexes
+    Records are named after UID and card type, so a lookup opens one
+    file instead of scanning the store. Chunks no record uses anymore
+    are reused by the next saves, their bucket entries are dropped. Pool,
+    buckets and counts are written once per save/remove.
+*/
+class DumpStore
+{
+private:
+    friend class DumpChunkWriter;
+
+    fs::FS *fs;
+    char root[DUMP_STORE_PATH_MAX / 2];
+    fs::File pool;
+    fs::File refs_file;
+    std::vector<uint16_t> refs;         // Reference count of each pool chunk, 0 if free
+    size_t refs_first = 0;              // Counts changed since the last commit, first and past the last
+    size_t refs_last = 0;
+    size_t free_hint = 0;               // No free chunk before this one
+    std::vector<uint32_t> pending;      // Bucket entries(hash, index) not written yet
+    uint8_t stale_buckets[32] = {0};    // Bitmap of buckets with entries of freed chunks, compacted on commit
+
+    void record_path(const uint8_t *uid, uint8_t uid_length, const char *type, char *path);
+    // Index of chunk in the pool, stored in a free or new slot if it isn't there yet
+    int32_t store_chunk(const uint8_t *chunk);
+    bool find_chunk(const uint8_t *chunk, uint32_t hash, uint32_t *index);
+    void add_ref(uint32_t index, int delta);
+    // Hash of the chunk held by a pool slot
+    bool slot_hash(uint32_t index, uint32_t *hash);
+    // Rewrite a bucket with its live entries and the pending ones
+    bool compact_bucket(uint8_t id);
+    // Chunk indexes of the record at path
+    bool record_chunks(const char *path, std::vector<uint32_t> *chunks);
+    // Write the pending bucket entries and reference counts
+    bool commit();
+    NFCTag *load_record(fs::File *record);
+public:
+    DumpStore(fs::FS *_fs, const char *_root = "/dumps") {
+        fs = _fs;
+        strncpy(root, _root, sizeof(root) - 1);
+        root[sizeof(root) - 1] = '\0';
+    };
+    ~DumpStore() { end(); };
+    // Create the store directories and open the chunk pool
+    bool begin();
+    void end();
+
+    // Save tag replacing a previous dump of the same card
+    bool save(NFCTag *tag);
+    // Load the dump of a card, type as in export_type_name(NULL for any). NULL if not stored
+    NFCTag *load(const uint8_t *uid, uint8_t uid_length, const char *type = NULL);
+    bool contains(const uint8_t *uid, uint8_t uid_length, const char *type = NULL);
+    bool remove(const uint8_t *uid, uint8_t uid_length, const char *type = NULL);
+    // Chunk slots in the pool, free ones included
+    size_t pool_chunks();
+    // Chunks used by at least one record
+    size_t used_chunks();
+};
+
+#endif
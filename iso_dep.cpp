@@ -0,0 +1,216 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "iso_dep.hpp"
+
+void IsoDep::pick_rates(IsoDepInfo *info, uint8_t max_rate)
+{
+    info->send_rate = ISO_DEP_106;
+    info->receive_rate = ISO_DEP_106;
+
+    /* ATS: TL, T0, TA(1) if T0 bit 5 is set */
+    if (info->ats_length < 3 || !(info->ats[1] & 0x10))
+        return;
+    uint8_t ta = info->ats[2];
+    // One bit per InPSL rate, 106 kbps is always supported
+    uint8_t send = 0x01 | ((ta & 0x01) ? 0x02 : 0) | ((ta & 0x02) ? 0x04 : 0);       // DR
+    uint8_t receive = 0x01 | ((ta & 0x10) ? 0x02 : 0) | ((ta & 0x20) ? 0x04 : 0);    // DS
+    if (ta & 0x80)
+    {
+        // Card needs the same rate in both directions
+        send &= receive;
+        receive = send;
+    }
+
+    /* Highest rate the card lists, TA(1) can skip 212 kbps so don't just cap its maximum */
+    for (uint8_t rate = ISO_DEP_106; rate <= max_rate && rate <= ISO_DEP_424; rate++)
+    {
+        if (send & (1 << rate))
+            info->send_rate = rate;
+        if (receive & (1 << rate))
+            info->receive_rate = rate;
+    }
+}
+
+bool IsoDep::select(IsoDepInfo *info, uint8_t max_rate)
+{
+    uint8_t cmd[] = {PN532_COMMAND_INLISTPASSIVETARGET, 1, PN532_MIFARE_ISO14443A};
+    uint8_t response[64];
+    *info = IsoDepInfo();
+
+    /* NbTg, Tg, SENS_RES(2 bytes), SEL_RES, NFCID1 length, NFCID1, ATS(PN532 sends RATS by itself) */
+    int16_t len = transport->command(cmd, sizeof(cmd), response, sizeof(response), ISO_DEP_TIMEOUT);
+    if (len < 6 || response[0] != 1 || response[5] > 7 || len < 6 + response[5])
+        return false;
+    info->atqa = (response[2] << 8) | response[3];
+    info->sak = response[4];
+    info->uid_length = response[5];
+    memcpy(info->uid, &response[6], info->uid_length);
+    if (!(info->sak & ISO_DEP_SAK_14443_4))
+        return false;
+
+    uint8_t *ats = &response[6 + info->uid_length];
+    len -= 6 + info->uid_length;
+    if (len > 0)
+    {
+        info->ats_length = ats[0] > len ? len : ats[0];
+        if (info->ats_length > ISO_DEP_ATS_MAX)
+            info->ats_length = ISO_DEP_ATS_MAX;
+        memcpy(info->ats, ats, info->ats_length);
+    }
+
+    pick_rates(info, max_rate);
+    if (info->send_rate == ISO_DEP_106 && info->receive_rate == ISO_DEP_106)
+        return true;
+
+    /* PPS through InPSL, stay at 106 kbps if the card refuses it */
+    uint8_t psl[] = {PN532_COMMAND_INPSL, 1, info->send_rate, info->receive_rate};
+    uint8_t status[1];
+    if (transport->command(psl, sizeof(psl), status, sizeof(status), ISO_DEP_TIMEOUT) < 1 || (status[0] & 0x3F) != 0)
+    {
+        info->send_rate = ISO_DEP_106;
+        info->receive_rate = ISO_DEP_106;
+    }
+    return true;
+}
+
+int32_t IsoDep::exchange(const uint8_t *data, size_t len, uint8_t *response, size_t response_max)
+{
+    uint8_t cmd[2 + ISO_DEP_FRAME_DATA] = {PN532_COMMAND_INDATAEXCHANGE};
+    uint8_t answer[255];
+    int16_t answer_len;
+
+    /* Chain the command: every frame but the last has MI set in Tg */
+    do
+    {
+        size_t chunk = len > ISO_DEP_FRAME_DATA ? ISO_DEP_FRAME_DATA : len;
+        cmd[1] = 1 | (len > chunk ? ISO_DEP_MI : 0);
+        memcpy(&cmd[2], data, chunk);
+        data += chunk;
+        len -= chunk;
+        answer_len = transport->command(cmd, 2 + chunk, answer, sizeof(answer), ISO_DEP_TIMEOUT);
+        if (answer_len < 1 || (answer[0] & 0x3F) != 0)
+            return -1;
+    } while (len > 0);
+
+    /* Collect the answer, PN532 sets MI in the status while more data is waiting */
+    size_t received = 0;
+    bool overflow = false;
+    while (true)
+    {
+        size_t chunk = answer_len - 1;
+        if (received + chunk > response_max)
+            overflow = true;
+        else
+            memcpy(&response[received], &answer[1], chunk);
+        received += chunk;
+        if (!(answer[0] & ISO_DEP_MI))
+            break;
+
+        cmd[1] = 1;
+        answer_len = transport->command(cmd, 2, answer, sizeof(answer), ISO_DEP_TIMEOUT);
+        if (answer_len < 1 || (answer[0] & 0x3F) != 0)
+            return -1;
+    }
+    return overflow ? -1 : received;
+}
+
+/*
+    Copy apdu to out with Le set to le(1-256), adding it to case 1 and 3
+    APDUs. Return the new length, 0 if apdu matches no ISO 7816-4 case
+*/
+static size_t apdu_set_le(const uint8_t *apdu, size_t apdu_len, uint16_t le, uint8_t *out)
+{
+    size_t body;            // Header, Lc and data, without Le
+    bool extended = false;
+    if (apdu_len == 4 || apdu_len == 5)
+    {
+        body = 4;           // Case 1, 2S
+    }
+    else if (apdu_len > 5 && apdu[4] != 0)
+    {
+        size_t lc = apdu[4];
+        if (apdu_len == 5 + lc)
+            body = apdu_len;    // Case 3S
+        else if (apdu_len == 6 + lc)
+            body = 5 + lc;      // Case 4S
+        else
+            return 0;
+    }
+    else if (apdu_len >= 7)
+    {
+        size_t lc = (apdu[5] << 8) | apdu[6];
+        extended = true;
+        if (apdu_len == 7)
+            body = 4;           // Case 2E
+        else if (apdu_len == 7 + lc)
+            body = apdu_len;    // Case 3E
+        else if (apdu_len == 9 + lc)
+            body = 7 + lc;      // Case 4E
+        else
+            return 0;
+    }
+    else
+    {
+        return 0;
+    }
+
+    memcpy(out, apdu, body);
+    if (!extended)
+    {
+        out[body] = le;     // 256 is 0x00
+        return body + 1;
+    }
+    if (body == 4)
+        out[body++] = 0x00; // Extended Le without Lc starts with a zero byte
+    out[body] = le >> 8;
+    out[body + 1] = le;
+    return body + 2;
+}
+
+int32_t IsoDep::transceive(const uint8_t *apdu, size_t apdu_len, uint8_t *response, size_t response_max)
+{
+    int32_t len = exchange(apdu, apdu_len, response, response_max);
+    if (len < 2)
+        return -1;
+
+    /* 6Cxx: wrong Le, send the same APDU again with Le = xx */
+    if (response[len - 2] == 0x6C)
+    {
+        uint8_t *retry = new uint8_t[apdu_len + 3];
+        size_t retry_len = apdu_set_le(apdu, apdu_len, response[len - 1] == 0 ? 256 : response[len - 1], retry);
+        len = retry_len == 0 ? -1 : exchange(retry, retry_len, response, response_max);
+        delete[] retry;
+        if (len < 2)
+            return -1;
+    }
+
+    /* 61xx: xx bytes still available, GET RESPONSE appending them in place of the status word */
+    while (response[len - 2] == 0x61)
+    {
+        uint8_t get_response[] = {0x00, 0xC0, 0x00, 0x00, response[len - 1]};
+        size_t expected = response[len - 1] == 0 ? ISO_DEP_GET_RESPONSE_MAX : response[len - 1];
+        len -= 2;
+        if ((size_t)len + expected + 2 > response_max)
+            return -1;
+        int32_t more = exchange(get_response, sizeof(get_response), &response[len], response_max - len);
+        if (more < 2)
+            return -1;
+        len += more;
+    }
+    return len;
+}
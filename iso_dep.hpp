@@ -0,0 +1,81 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ISO_DEP_H
+#define ISO_DEP_H
+
+#include <Adafruit_PN532.h>
+#include "pn532_transport.hpp"
+
+#ifndef PN532_COMMAND_INPSL
+#define PN532_COMMAND_INPSL 0x4E
+#endif
+
+// InPSL bit rates
+#define ISO_DEP_106 0x00
+#define ISO_DEP_212 0x01
+#define ISO_DEP_424 0x02
+
+#define ISO_DEP_FRAME_DATA 252      // InDataExchange data per frame: LEN 255 minus TFI, command and Tg
+#define ISO_DEP_MI 0x40             // More information bit of Tg and of the status byte
+#define ISO_DEP_TIMEOUT 1000        // Cards can ask for waiting time extensions
+#define ISO_DEP_SAK_14443_4 0x20
+#define ISO_DEP_ATS_MAX 20
+#define ISO_DEP_GET_RESPONSE_MAX 256
+
+typedef struct IsoDepInfo {
+    uint8_t uid[7] = {0};
+    uint8_t uid_length = 0;
+    uint16_t atqa = 0;
+    uint8_t sak = 0;
+    uint8_t ats[ISO_DEP_ATS_MAX] = {0};
+    uint8_t ats_length = 0;
+    uint8_t send_rate = ISO_DEP_106;    // Reader to card
+    uint8_t receive_rate = ISO_DEP_106; // Card to reader
+} IsoDepInfo;
+
+/*
+    ISO 14443-4 link for EMV, DESFire and other smart cards.
+    PN532 runs the block protocol; this layer picks the fastest bit
+    rate the card and the reader share, chains long APDUs and long
+    answers through the MI bit and follows 61xx/6Cxx status words, so
+    responses of any length land in the caller buffer. An exchange the
+    card doesn't answer within ISO_DEP_TIMEOUT is aborted by the
+    transport with an ACK frame, the next APDU starts on a clean PN532.
+*/
+class IsoDep
+{
+private:
+    PN532Transport *transport;
+
+    // Bit rate to use from ATS TA(1), limited to max_rate
+    static void pick_rates(IsoDepInfo *info, uint8_t max_rate);
+    // Chained InDataExchange, return the response length or -1
+    int32_t exchange(const uint8_t *data, size_t len, uint8_t *response, size_t response_max);
+public:
+    IsoDep(PN532Transport *_transport) { transport = _transport; };
+    // Activate an ISO 14443-4A card and switch to the fastest bit rate up to max_rate
+    bool select(IsoDepInfo *info, uint8_t max_rate = ISO_DEP_424);
+    /*
+        Send a command APDU(short or extended) and put the answer, status
+        word included, in response. Return its length, -1 on error or if
+        it doesn't fit in response_max
+    */
+    int32_t transceive(const uint8_t *apdu, size_t apdu_len, uint8_t *response, size_t response_max);
+};
+
+#endif
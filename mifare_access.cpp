@@ -0,0 +1,88 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mifare_access.hpp"
+
+/* Data block conditions from MF1S50 datasheet: read, write, increment, decrement/transfer/restore */
+static const uint8_t data_access[8][4] = {
+    {ACCESS_KEY_AB, ACCESS_KEY_AB, ACCESS_KEY_AB, ACCESS_KEY_AB},   // 000
+    {ACCESS_KEY_AB, ACCESS_NEVER, ACCESS_NEVER, ACCESS_KEY_AB},     // 001
+    {ACCESS_KEY_AB, ACCESS_NEVER, ACCESS_NEVER, ACCESS_NEVER},      // 010
+    {ACCESS_KEY_B, ACCESS_KEY_B, ACCESS_NEVER, ACCESS_NEVER},       // 011
+    {ACCESS_KEY_AB, ACCESS_KEY_B, ACCESS_NEVER, ACCESS_NEVER},      // 100
+    {ACCESS_KEY_B, ACCESS_NEVER, ACCESS_NEVER, ACCESS_NEVER},       // 101
+    {ACCESS_KEY_AB, ACCESS_KEY_B, ACCESS_KEY_B, ACCESS_KEY_AB},     // 110
+    {ACCESS_NEVER, ACCESS_NEVER, ACCESS_NEVER, ACCESS_NEVER}        // 111
+};
+
+/* Sector trailer conditions: read and write of the access bits */
+static const uint8_t trailer_access[8][2] = {
+    {ACCESS_KEY_A, ACCESS_NEVER},   // 000
+    {ACCESS_KEY_A, ACCESS_KEY_A},   // 001
+    {ACCESS_KEY_A, ACCESS_NEVER},   // 010
+    {ACCESS_KEY_AB, ACCESS_KEY_B},  // 011
+    {ACCESS_KEY_AB, ACCESS_NEVER},  // 100
+    {ACCESS_KEY_AB, ACCESS_KEY_B},  // 101
+    {ACCESS_KEY_AB, ACCESS_NEVER},  // 110
+    {ACCESS_KEY_AB, ACCESS_NEVER}   // 111
+};
+
+bool mifare_access_decode(const uint8_t *trailer, SectorAccess *access)
+{
+    access->valid = false;
+    for (uint8_t group = 0; group < 4; group++)
+    {
+        uint8_t c1 = (trailer[7] >> (4 + group)) & 1;
+        uint8_t c2 = (trailer[8] >> group) & 1;
+        uint8_t c3 = (trailer[8] >> (4 + group)) & 1;
+        if (c1 == ((trailer[6] >> group) & 1) || c2 == ((trailer[6] >> (4 + group)) & 1) || c3 == ((trailer[7] >> group) & 1))
+            return false;
+        access->conditions[group] = (c1 << 2) | (c2 << 1) | c3;
+    }
+    access->valid = true;
+    return true;
+}
+
+uint8_t mifare_access_group(uint8_t block_offset, uint8_t sector_blocks)
+{
+    if (block_offset == sector_blocks - 1)
+        return ACCESS_TRAILER_GROUP;
+    return sector_blocks == 4 ? block_offset : block_offset / 5;
+}
+
+bool mifare_access_key_b_readable(const SectorAccess *access)
+{
+    uint8_t condition = access->conditions[ACCESS_TRAILER_GROUP];
+    return condition == 0b000 || condition == 0b010 || condition == 0b001;
+}
+
+uint8_t mifare_access_allowed(const SectorAccess *access, uint8_t group, AccessOperation op)
+{
+    if (!access->valid)
+        return ACCESS_KEY_AB;
+
+    uint8_t allowed;
+    uint8_t condition = access->conditions[group];
+    if (group == ACCESS_TRAILER_GROUP)
+        allowed = op == ACCESS_READ ? trailer_access[condition][0] : op == ACCESS_WRITE ? trailer_access[condition][1] : ACCESS_NEVER;
+    else
+        allowed = data_access[condition][op];
+
+    if (mifare_access_key_b_readable(access))
+        allowed &= ~ACCESS_KEY_B;
+    return allowed;
+}
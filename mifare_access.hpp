@@ -0,0 +1,58 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIFARE_ACCESS_H
+#define MIFARE_ACCESS_H
+
+#include <stdint.h>
+
+#define MIFARE_CLASSIC_MAX_SECTORS 40
+#define ACCESS_TRAILER_GROUP 3
+
+// Keys allowed for an operation
+#define ACCESS_NEVER 0x00
+#define ACCESS_KEY_A 0x01
+#define ACCESS_KEY_B 0x02
+#define ACCESS_KEY_AB (ACCESS_KEY_A | ACCESS_KEY_B)
+
+typedef enum AccessOperation {
+    ACCESS_READ,
+    ACCESS_WRITE,
+    ACCESS_INCREMENT,
+    ACCESS_DECREMENT    // Decrement, transfer and restore share the same condition
+} AccessOperation;
+
+/*
+    Access conditions of a sector as C1C2C3 bits(C1 is the MSB),
+    indexed by block group: 0-2 data blocks, 3 sector trailer.
+    On 4K cards big sectors have groups of five data blocks.
+*/
+typedef struct SectorAccess {
+    bool valid = false;
+    uint8_t conditions[4] = {0};
+} SectorAccess;
+
+// Decode access bits from trailer bytes 6-8, false if the inverted copies don't match
+bool mifare_access_decode(const uint8_t *trailer, SectorAccess *access);
+// Group of the block inside its sector
+uint8_t mifare_access_group(uint8_t block_offset, uint8_t sector_blocks);
+// ACCESS_KEY_* mask of keys that can run op on blocks in group
+uint8_t mifare_access_allowed(const SectorAccess *access, uint8_t group, AccessOperation op);
+// When Key B can be read from the trailer it's plain data and can't authenticate
+bool mifare_access_key_b_readable(const SectorAccess *access);
+
+#endif
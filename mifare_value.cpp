@@ -0,0 +1,56 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include "mifare_value.hpp"
+
+static void put_le32(uint32_t value, uint8_t *out)
+{
+    out[0] = value;
+    out[1] = value >> 8;
+    out[2] = value >> 16;
+    out[3] = value >> 24;
+}
+
+static uint32_t get_le32(const uint8_t *in)
+{
+    return in[0] | (in[1] << 8) | (in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+void mifare_value_encode(int32_t value, uint8_t address, uint8_t *block)
+{
+    put_le32((uint32_t)value, block);
+    put_le32(~(uint32_t)value, &block[4]);
+    put_le32((uint32_t)value, &block[8]);
+    block[12] = address;
+    block[13] = ~address;
+    block[14] = address;
+    block[15] = ~address;
+}
+
+bool mifare_value_decode(const uint8_t *block, int32_t *value, uint8_t *address)
+{
+    uint32_t raw = get_le32(block);
+    if (get_le32(&block[4]) != ~raw || get_le32(&block[8]) != raw)
+        return false;
+    if (block[13] != (uint8_t)~block[12] || block[14] != block[12] || block[15] != block[13])
+        return false;
+    *value = (int32_t)raw;
+    if (address != NULL)
+        *address = block[12];
+    return true;
+}
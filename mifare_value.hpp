@@ -0,0 +1,55 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIFARE_VALUE_H
+#define MIFARE_VALUE_H
+
+#include <stdint.h>
+
+typedef enum ValueOpType {
+    VALUE_READ,         // Read and decode the block into value
+    VALUE_SET,          // Format the block as value block holding value
+    VALUE_INCREMENT,    // Add value and transfer the result to transfer_block
+    VALUE_DECREMENT,    // Subtract value and transfer the result to transfer_block
+    VALUE_RESTORE       // Copy the block to transfer_block(backup)
+} ValueOpType;
+
+typedef enum ValueStatus {
+    VALUE_OK,
+    VALUE_NOT_RUN,          // Batch stopped before this operation
+    VALUE_DENIED,           // Access conditions deny it or no valid key
+    VALUE_BAD_FORMAT,       // Block isn't a value block or blocks are in different sectors
+    VALUE_FAILED            // Card didn't accept the command
+} ValueStatus;
+
+typedef struct ValueOperation {
+    ValueOpType type = VALUE_READ;
+    uint8_t block = 0;
+    int32_t value = 0;              // Operand, VALUE_READ puts the block value here
+    uint8_t transfer_block = 0;     // Destination of increment/decrement/restore, same sector of block
+    ValueStatus status = VALUE_NOT_RUN;
+} ValueOperation;
+
+/*
+    Value block layout: value, inverted value, value(4 bytes LSB first each),
+    then address, inverted address, address, inverted address
+*/
+void mifare_value_encode(int32_t value, uint8_t address, uint8_t *block);
+// False if the redundant copies don't match
+bool mifare_value_decode(const uint8_t *block, int32_t *value, uint8_t *address);
+
+#endif
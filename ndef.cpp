@@ -0,0 +1,186 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "ndef.hpp"
+
+// URI identifier codes as per NFC Forum URI RTD
+static const char *uri_prefixes[] = {
+    "", "http://www.", "https://www.", "http://", "https://", "tel:", "mailto:",
+    "ftp://anonymous:anonymous@", "ftp://ftp.", "ftps://", "sftp://", "smb://",
+    "nfs://", "ftp://", "dav://", "news:", "telnet://", "imap:", "rtsp://", "urn:",
+    "pop:", "sip:", "sips:", "tftp:", "btspp://", "btl2cap://", "btgoep://",
+    "tcpobex://", "irdaobex://", "file://", "urn:epc:id:", "urn:epc:tag:",
+    "urn:epc:pat:", "urn:epc:raw:", "urn:epc:", "urn:nfc:"
+};
+#define URI_PREFIXES_COUNT (sizeof(uri_prefixes) / sizeof(uri_prefixes[0]))
+
+bool NDEFParser::next(NDEFRecord *record)
+{
+    if (last || offset >= length)
+        return false;
+
+    uint8_t header = message[offset++];
+    size_t header_len = (header & NDEF_SR) ? 2 : 5;
+    if (header & NDEF_IL)
+        header_len++;
+    // Chunks are only a part of the payload, they aren't records on their own
+    if ((header & NDEF_CF) || header_len > length - offset)
+        return false;
+
+    record->tnf = header & NDEF_TNF_MASK;
+    record->type_length = message[offset++];
+    if (header & NDEF_SR)
+    {
+        record->payload_length = message[offset++];
+    }
+    else
+    {
+        record->payload_length = ((uint32_t)message[offset] << 24) | ((uint32_t)message[offset + 1] << 16) |
+                                 ((uint32_t)message[offset + 2] << 8) | message[offset + 3];
+        offset += 4;
+    }
+    record->id_length = (header & NDEF_IL) ? message[offset++] : 0;
+
+    /* Check each field against what is left, a sum of the lengths could wrap */
+    size_t remaining = length - offset;
+    if (record->type_length > remaining)
+        return false;
+    remaining -= record->type_length;
+    if (record->id_length > remaining)
+        return false;
+    remaining -= record->id_length;
+    if (record->payload_length > remaining)
+        return false;
+    record->type = &message[offset];
+    offset += record->type_length;
+    record->id = record->id_length ? &message[offset] : NULL;
+    offset += record->id_length;
+    record->payload = &message[offset];
+    offset += record->payload_length;
+
+    last = header & NDEF_ME;
+    return true;
+}
+
+size_t ndef_record_length(const NDEFRecord *record)
+{
+    size_t len = 2 + record->type_length + record->payload_length;  // Header, type length
+    len += record->payload_length < 256 ? 1 : 4;
+    if (record->id_length)
+        len += 1 + record->id_length;
+    return len;
+}
+
+size_t ndef_message_length(const NDEFRecord *records, size_t count)
+{
+    size_t len = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        len += ndef_record_length(&records[i]);
+    }
+    return len;
+}
+
+void ndef_encode_message(const NDEFRecord *records, size_t count, std::function<void(uint8_t)> emit)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const NDEFRecord *record = &records[i];
+        bool short_record = record->payload_length < 256;
+        uint8_t header = record->tnf & NDEF_TNF_MASK;
+        if (i == 0)
+            header |= NDEF_MB;
+        if (i == count - 1)
+            header |= NDEF_ME;
+        if (short_record)
+            header |= NDEF_SR;
+        if (record->id_length)
+            header |= NDEF_IL;
+
+        emit(header);
+        emit(record->type_length);
+        if (short_record)
+        {
+            emit(record->payload_length);
+        }
+        else
+        {
+            emit(record->payload_length >> 24);
+            emit(record->payload_length >> 16);
+            emit(record->payload_length >> 8);
+            emit(record->payload_length);
+        }
+        if (record->id_length)
+            emit(record->id_length);
+        for (uint8_t j = 0; j < record->type_length; j++)
+            emit(record->type[j]);
+        for (uint8_t j = 0; j < record->id_length; j++)
+            emit(record->id[j]);
+        for (uint32_t j = 0; j < record->payload_length; j++)
+            emit(record->payload[j]);
+    }
+}
+
+size_t ndef_uri_payload(const char *uri, uint8_t *out, size_t max_len)
+{
+    /* Use the longest matching abbreviation */
+    uint8_t code = 0;
+    size_t prefix_len = 0;
+    for (uint8_t i = 1; i < URI_PREFIXES_COUNT; i++)
+    {
+        size_t len = strlen(uri_prefixes[i]);
+        if (len > prefix_len && strncmp(uri, uri_prefixes[i], len) == 0)
+        {
+            code = i;
+            prefix_len = len;
+        }
+    }
+    size_t len = strlen(uri) - prefix_len;
+    if (len + 1 > max_len)
+        return 0;
+    out[0] = code;
+    memcpy(&out[1], uri + prefix_len, len);
+    return len + 1;
+}
+
+size_t ndef_text_payload(const char *text, const char *lang, uint8_t *out, size_t max_len)
+{
+    size_t lang_len = strlen(lang);
+    size_t text_len = strlen(text);
+    if (lang_len > 0x3F || 1 + lang_len + text_len > max_len)
+        return 0;
+    out[0] = lang_len; // UTF-8
+    memcpy(&out[1], lang, lang_len);
+    memcpy(&out[1 + lang_len], text, text_len);
+    return 1 + lang_len + text_len;
+}
+
+bool ndef_uri_to_string(const NDEFRecord *record, char *out, size_t max_len)
+{
+    if (record->tnf != NDEF_TNF_WELL_KNOWN || record->type_length != 1 || record->type[0] != 'U' ||
+        record->payload_length < 1 || record->payload[0] >= URI_PREFIXES_COUNT)
+        return false;
+    const char *prefix = uri_prefixes[record->payload[0]];
+    size_t prefix_len = strlen(prefix);
+    if (prefix_len + record->payload_length > max_len)    // payload_length - 1 + NUL
+        return false;
+    memcpy(out, prefix, prefix_len);
+    memcpy(&out[prefix_len], &record->payload[1], record->payload_length - 1);
+    out[prefix_len + record->payload_length - 1] = '\0';
+    return true;
+}
@@ -0,0 +1,96 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NDEF_H
+#define NDEF_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+
+// Type 2 tag TLV blocks
+#define NDEF_TLV_NULL 0x00
+#define NDEF_TLV_LOCK_CONTROL 0x01
+#define NDEF_TLV_MEMORY_CONTROL 0x02
+#define NDEF_TLV_MESSAGE 0x03
+#define NDEF_TLV_TERMINATOR 0xFE
+#define NDEF_CC_MAGIC 0xE1
+#define NDEF_CC_PAGE 3
+#define NDEF_DATA_PAGE 4
+
+// Record header flags
+#define NDEF_MB 0x80
+#define NDEF_ME 0x40
+#define NDEF_CF 0x20
+#define NDEF_SR 0x10
+#define NDEF_IL 0x08
+#define NDEF_TNF_MASK 0x07
+
+// Type name formats
+#define NDEF_TNF_EMPTY 0x00
+#define NDEF_TNF_WELL_KNOWN 0x01
+#define NDEF_TNF_MIME 0x02
+#define NDEF_TNF_ABSOLUTE_URI 0x03
+#define NDEF_TNF_EXTERNAL 0x04
+#define NDEF_TNF_UNKNOWN 0x05
+#define NDEF_TNF_UNCHANGED 0x06
+
+// FeliCa NDEF(Type 3 tag) definitions
+#define FELICA_NDEF_SERVICE_READ 0x000B
+#define FELICA_NDEF_SERVICE_WRITE 0x0009
+#define FELICA_MAX_BLOCKS_PER_READ 12   // What fits in a PN532 frame
+
+/*
+    Record pointing inside the buffer it was parsed from, nothing is copied.
+    The same structure describes records to write.
+*/
+typedef struct NDEFRecord {
+    uint8_t tnf = NDEF_TNF_EMPTY;
+    const uint8_t *type = NULL;
+    uint8_t type_length = 0;
+    const uint8_t *id = NULL;
+    uint8_t id_length = 0;
+    const uint8_t *payload = NULL;
+    uint32_t payload_length = 0;
+} NDEFRecord;
+
+class NDEFParser
+{
+private:
+    const uint8_t *message;
+    size_t length;
+    size_t offset = 0;
+    bool last = false;
+public:
+    NDEFParser(const uint8_t *_message, size_t _length) : message(_message), length(_length) {};
+    // Fill record with the next record of the message, false at the end, on malformed data or chunked(CF) records
+    bool next(NDEFRecord *record);
+};
+
+// Size of the encoded record/message
+size_t ndef_record_length(const NDEFRecord *record);
+size_t ndef_message_length(const NDEFRecord *records, size_t count);
+// Encode records one byte at a time, so the caller can stream them to the tag
+void ndef_encode_message(const NDEFRecord *records, size_t count, std::function<void(uint8_t)> emit);
+
+// Well known URI("U") and text("T") payload helpers, return payload length or 0 if out is too small
+size_t ndef_uri_payload(const char *uri, uint8_t *out, size_t max_len);
+size_t ndef_text_payload(const char *text, const char *lang, uint8_t *out, size_t max_len);
+// Expand URI payload in out as a NUL terminated string
+bool ndef_uri_to_string(const NDEFRecord *record, char *out, size_t max_len);
+
+#endif
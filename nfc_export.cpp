@@ -0,0 +1,708 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "nfc_export.hpp"
+
+static const char hex_digits[] = "0123456789ABCDEF";
+
+/* Dump planner names with the Flipper type and GET_VERSION answer of the card */
+typedef struct FlipperType {
+    const char *name;
+    const char *flipper;
+    uint8_t version[8];
+} FlipperType;
+
+static const FlipperType flipper_types[] = {
+    {"Mifare Ultralight", "Mifare Ultralight", {0}},
+    {"Mifare Ultralight C", "Mifare Ultralight C", {0}},
+    {"Mifare Ultralight EV1 MF0UL11", "Mifare Ultralight 11", {0x00, 0x04, 0x03, 0x01, 0x01, 0x00, 0x0B, 0x03}},
+    {"Mifare Ultralight EV1 MF0UL21", "Mifare Ultralight 21", {0x00, 0x04, 0x03, 0x01, 0x01, 0x00, 0x0E, 0x03}},
+    {"NTAG203", "NTAG203", {0}},
+    // Flipper has no NTAG210/212 type, it reads them as plain Ultralight
+    {"NTAG210", "Mifare Ultralight", {0x00, 0x04, 0x04, 0x01, 0x01, 0x00, 0x0B, 0x03}},
+    {"NTAG212", "Mifare Ultralight", {0x00, 0x04, 0x04, 0x01, 0x01, 0x00, 0x0E, 0x03}},
+    {"NTAG213", "NTAG213", {0x00, 0x04, 0x04, 0x02, 0x01, 0x00, 0x0F, 0x03}},
+    {"NTAG215", "NTAG215", {0x00, 0x04, 0x04, 0x02, 0x01, 0x00, 0x11, 0x03}},
+    {"NTAG216", "NTAG216", {0x00, 0x04, 0x04, 0x02, 0x01, 0x00, 0x13, 0x03}}
+};
+
+// Type of a planner name, unknown ones(e.g. "Type 2 tag") are exported as Ultralight
+static const FlipperType *flipper_type(const char *name)
+{
+    for (size_t i = 0; name != NULL && i < sizeof(flipper_types) / sizeof(flipper_types[0]); i++)
+    {
+        if (strcmp(flipper_types[i].name, name) == 0)
+            return &flipper_types[i];
+    }
+    return &flipper_types[0];
+}
+
+// Page counts import_mfd accepts: Ultralight, EV1 or NTAG210/212, Ultralight C, NTAG213/215/216
+static const uint16_t mfd_page_counts[] = {16, 20, 41, 48, 45, 135, 231};
+
+/*
+    Tags are exported as a list of units: 16 bytes blocks for Classic and
+    FeliCa, 4 bytes pages for Ultralight/NTAG. Old Ultralight dumps keep
+    each page at a 16 bytes stride, only the first 4 bytes are real data.
+*/
+static bool is_paged(NFCTag *tag)
+{
+    return !tag->is_felica() && (tag->is_ntag() || tag->is_ultralight());
+}
+
+static size_t unit_size(NFCTag *tag)
+{
+    return is_paged(tag) ? NTAG_PAGE_SIZE : BLOCK_SIZE;
+}
+
+static void get_unit(NFCTag *tag, size_t index, uint8_t *out)
+{
+    uint8_t block[BLOCK_SIZE];
+    if (tag->is_ntag() || !is_paged(tag))
+    {
+        tag->get_block(index, out);
+        return;
+    }
+    tag->get_block(index, block);
+    memcpy(out, block, NTAG_PAGE_SIZE);
+}
+
+const char *export_type_name(NFCTag *tag)
+{
+    if (tag->is_felica())
+        return "felica";
+    if (!is_paged(tag))
+        return "classic";
+    return tag->is_ultralight() ? "ultralight" : "ntag";
+}
+
+static uint16_t tag_atqa(NFCTag *tag)
+{
+    uint8_t atqa[2];
+    tag->get_atqa(atqa);
+    return (atqa[0] << 8) | atqa[1];
+}
+
+static size_t write_hex(Print *out, const uint8_t *data, size_t len, bool spaced)
+{
+    char text[3 * BLOCK_SIZE];
+    size_t pos = 0;
+    for (size_t i = 0; i < len && i < BLOCK_SIZE; i++)
+    {
+        if (spaced && i > 0)
+            text[pos++] = ' ';
+        text[pos++] = hex_digits[data[i] >> 4];
+        text[pos++] = hex_digits[data[i] & 0x0F];
+    }
+    return out->write((const uint8_t *)text, pos);
+}
+
+static size_t write_text(Print *out, const char *text)
+{
+    return out->write((const uint8_t *)text, strlen(text));
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+
+// Parse "AABB.." or "AA BB ..", unknown "??" bytes become 0
+static size_t parse_hex(const char *text, uint8_t *out, size_t max_len)
+{
+    size_t len = 0;
+    while (*text != '\0' && len < max_len)
+    {
+        if (*text == ' ')
+        {
+            text++;
+            continue;
+        }
+        if (text[0] == '?' && text[1] == '?')
+        {
+            out[len++] = 0;
+            text += 2;
+            continue;
+        }
+        int high = hex_value(text[0]);
+        int low = high < 0 ? -1 : hex_value(text[1]);
+        if (low < 0)
+            break;
+        out[len++] = (high << 4) | low;
+        text += 2;
+    }
+    return len;
+}
+
+// Read a line without line terminator, false at end of stream
+static bool read_line(Stream *in, char *line, size_t max_len)
+{
+    size_t len = 0;
+    int c = in->read();
+    if (c < 0)
+        return false;
+    while (c >= 0 && c != '\n')
+    {
+        if (c != '\r' && len < max_len - 1)
+            line[len++] = c;
+        c = in->read();
+    }
+    line[len] = '\0';
+    return true;
+}
+
+size_t export_mfd(NFCTag *tag, Print *out)
+{
+    uint8_t unit[BLOCK_SIZE];
+    size_t size = unit_size(tag);
+    size_t written = 0;
+    for (size_t i = 0; i < tag->get_blocks_count(); i++)
+    {
+        get_unit(tag, i, unit);
+        written += out->write(unit, size);
+    }
+    return written;
+}
+
+size_t export_eml(NFCTag *tag, Print *out)
+{
+    uint8_t unit[BLOCK_SIZE];
+    size_t size = unit_size(tag);
+    size_t written = 0;
+    for (size_t i = 0; i < tag->get_blocks_count(); i++)
+    {
+        get_unit(tag, i, unit);
+        written += write_hex(out, unit, size, false);
+        written += write_text(out, "\n");
+    }
+    return written;
+}
+
+size_t export_flipper(NFCTag *tag, Print *out)
+{
+    uint8_t unit[BLOCK_SIZE];
+    char line[EXPORT_LINE_MAX];
+    size_t size = unit_size(tag);
+    size_t count = tag->get_blocks_count();
+    size_t written = write_text(out, "Filetype: Flipper NFC device\nVersion: 4\n");
+
+    if (tag->is_felica())
+    {
+        written += write_text(out, "Device type: FeliCa\nUID: ");
+        written += write_hex(out, tag->get_uid(), tag->get_uid_length(), true);
+        written += write_text(out, "\nData format version: 1\nManufacture id: ");
+        written += write_hex(out, tag->get_uid(), 8, true);
+        written += write_text(out, "\nManufacture parameter: ");
+        written += write_hex(out, tag->get_pmm(), 8, true);
+        snprintf(line, sizeof(line), "\nSystem code: %04X\nBlocks total: %u\n", tag->get_raw_sys_code(), (unsigned)count);
+        written += write_text(out, line);
+    }
+    else
+    {
+        uint16_t atqa = tag_atqa(tag);
+        written += write_text(out, is_paged(tag) ? "Device type: NTAG/Ultralight\nUID: " : "Device type: Mifare Classic\nUID: ");
+        written += write_hex(out, tag->get_uid(), tag->get_uid_length(), true);
+        // Flipper stores ATQA as received, LSB first
+        snprintf(line, sizeof(line), "\nATQA: %02X %02X\nSAK: %02X\n", atqa & 0xFF, atqa >> 8, tag->get_sak());
+        written += write_text(out, line);
+        if (is_paged(tag))
+        {
+            /* Signature, counters and tearing flags aren't dumped, Flipper wants them all the same */
+            const FlipperType *type = flipper_type(tag->get_name());
+            const uint8_t zero[BLOCK_SIZE] = {0};
+            snprintf(line, sizeof(line), "Data format version: 2\nNTAG/Ultralight type: %s\nSignature: ", type->flipper);
+            written += write_text(out, line);
+            written += write_hex(out, zero, BLOCK_SIZE, true);
+            written += write_text(out, " ");
+            written += write_hex(out, zero, BLOCK_SIZE, true);
+            written += write_text(out, "\nMifare version: ");
+            written += write_hex(out, type->version, sizeof(type->version), true);
+            written += write_text(out, "\n");
+            for (uint8_t counter = 0; counter < 3; counter++)
+            {
+                snprintf(line, sizeof(line), "Counter %u: 0\nTearing %u: 00\n", counter, counter);
+                written += write_text(out, line);
+            }
+            snprintf(line, sizeof(line), "Pages total: %u\nPages read: %u\n", (unsigned)count, (unsigned)count);
+        }
+        else
+        {
+            const char *type = count == 20 ? "MINI" : count == 128 ? "2K" : count == 256 ? "4K" : "1K";
+            snprintf(line, sizeof(line), "Mifare Classic type: %s\nData format version: 2\n", type);
+        }
+        written += write_text(out, line);
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        get_unit(tag, i, unit);
+        snprintf(line, sizeof(line), is_paged(tag) ? "Page %u: " : "Block %u: ", (unsigned)i);
+        written += write_text(out, line);
+        written += write_hex(out, unit, size, true);
+        written += write_text(out, "\n");
+    }
+    if (is_paged(tag))
+        written += write_text(out, "Failed authentication attempts: 0\n");
+    return written;
+}
+
+size_t export_json(NFCTag *tag, Print *out)
+{
+    uint8_t unit[BLOCK_SIZE];
+    char line[EXPORT_LINE_MAX];
+    size_t size = unit_size(tag);
+    size_t count = tag->get_blocks_count();
+    size_t written = 0;
+
+    snprintf(line, sizeof(line), "{\"type\":\"%s\",", export_type_name(tag));
+    written += write_text(out, line);
+    if (tag->get_name() != NULL)
+    {
+        snprintf(line, sizeof(line), "\"name\":\"%s\",", tag->get_name());
+        written += write_text(out, line);
+    }
+    written += write_text(out, "\"uid\":\"");
+    written += write_hex(out, tag->get_uid(), tag->get_uid_length(), false);
+    if (tag->is_felica())
+    {
+        written += write_text(out, "\",\"pmm\":\"");
+        written += write_hex(out, tag->get_pmm(), 8, false);
+        snprintf(line, sizeof(line), "\",\"sys_code\":\"%04X\",", tag->get_raw_sys_code());
+    }
+    else
+    {
+        snprintf(line, sizeof(line), "\",\"atqa\":\"%04X\",\"sak\":\"%02X\",", tag_atqa(tag), tag->get_sak());
+    }
+    written += write_text(out, line);
+    snprintf(line, sizeof(line), "\"blocks_count\":%u,\"blocks\":[", (unsigned)count);
+    written += write_text(out, line);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        get_unit(tag, i, unit);
+        written += write_text(out, i == 0 ? "\"" : ",\"");
+        written += write_hex(out, unit, size, false);
+        written += write_text(out, "\"");
+    }
+    written += write_text(out, "]}\n");
+    return written;
+}
+
+/* Shared import state: header fields first, then blocks go straight into the image */
+typedef struct ImportState {
+    CardFamily family = CARD_UNKNOWN;
+    bool felica = false;
+    uint8_t uid[8] = {0};
+    uint8_t uid_length = 0;
+    uint16_t atqa = 0;
+    uint8_t sak = 0;
+    uint8_t pmm[8] = {0};
+    uint16_t sys_code = 0;
+    uint16_t blocks_count = 0;
+    const char *name = NULL;    // Planner name of the paged card, when known
+    DumpPlan plan;
+    uint8_t *image = NULL;
+    uint8_t felica_data[FELICA_DUMP_BLOCKS][16] = {{0}};
+} ImportState;
+
+static bool import_alloc(ImportState *state)
+{
+    if (state->felica || state->image != NULL)
+        return true;
+    if (state->family == CARD_MIFARE_CLASSIC)
+    {
+        if (!dump_plan_classic_blocks(&state->plan, state->blocks_count))
+            return false;
+    }
+    else if (state->family == CARD_MIFARE_ULTRALIGHT || state->family == CARD_NTAG)
+    {
+        if (state->blocks_count == 0)
+            return false;
+        const char *name = state->name != NULL ? state->name : state->family == CARD_NTAG ? "NTAG" : "Mifare Ultralight";
+        dump_plan_pages(&state->plan, name, state->family, state->blocks_count);
+    }
+    else
+    {
+        return false;
+    }
+    state->plan.uid_length = state->uid_length > 7 ? 7 : state->uid_length;
+    memcpy(state->plan.uid, state->uid, state->plan.uid_length);
+    state->plan.atqa = state->atqa;
+    state->plan.sak = state->sak;
+    state->image = (uint8_t *)calloc(dump_plan_image_size(&state->plan), 1);
+    return state->image != NULL;
+}
+
+static bool import_unit(ImportState *state, size_t index, const uint8_t *data, size_t len)
+{
+    if (state->felica)
+    {
+        if (index >= FELICA_DUMP_BLOCKS || len != 16)
+            return false;
+        memcpy(state->felica_data[index], data, 16);
+        return true;
+    }
+    if (!import_alloc(state) || index >= state->plan.blocks || len != state->plan.unit_size)
+        return false;
+    memcpy(&state->image[index * state->plan.unit_size], data, len);
+    return true;
+}
+
+static NFCTag *import_finish(ImportState *state, bool success)
+{
+    if (!success)
+    {
+        free(state->image);
+        return NULL;
+    }
+    if (state->felica)
+        return new NFCTag(state->uid, state->pmm, state->sys_code, state->felica_data);
+    if (state->image == NULL && !import_alloc(state))
+        return NULL;
+    return new NFCTag(state->image, &state->plan);
+}
+
+// UID and anticollision data saved by the card itself in block 0/pages 0-1
+static void import_manufacturer_data(ImportState *state)
+{
+    if (state->family == CARD_MIFARE_CLASSIC)
+    {
+        state->uid_length = 4;
+        memcpy(state->uid, state->image, 4);
+        state->sak = state->image[5];
+        state->atqa = (state->image[7] << 8) | state->image[6];
+    }
+    else
+    {
+        state->uid_length = 7;
+        memcpy(state->uid, state->image, 3);
+        memcpy(&state->uid[3], &state->image[4], 4);
+        state->sak = 0x00;
+        state->atqa = 0x0044;
+    }
+    memcpy(state->plan.uid, state->uid, state->uid_length);
+    state->plan.uid_length = state->uid_length;
+    state->plan.atqa = state->atqa;
+    state->plan.sak = state->sak;
+}
+
+NFCTag *import_mfd(Stream *in, size_t size)
+{
+    ImportState state;
+    if (size % BLOCK_SIZE == 0 && dump_plan_classic_blocks(&state.plan, size / BLOCK_SIZE))
+    {
+        state.family = CARD_MIFARE_CLASSIC;
+    }
+    else if (size % NTAG_PAGE_SIZE == 0)
+    {
+        /* Raw images carry no type, only sizes of real cards are taken */
+        for (size_t i = 0; i < sizeof(mfd_page_counts) / sizeof(mfd_page_counts[0]); i++)
+        {
+            if (size / NTAG_PAGE_SIZE == mfd_page_counts[i])
+            {
+                state.family = CARD_NTAG;
+                dump_plan_pages(&state.plan, "NTAG", CARD_NTAG, mfd_page_counts[i]);
+            }
+        }
+    }
+    if (state.family == CARD_UNKNOWN)
+        return NULL;
+
+    state.image = (uint8_t *)malloc(size);
+    if (state.image == NULL)
+        return NULL;
+    bool success = in->readBytes(state.image, size) == size;
+    if (success)
+        import_manufacturer_data(&state);
+    return import_finish(&state, success);
+}
+
+NFCTag *import_eml(Stream *in)
+{
+    ImportState state;
+    char line[EXPORT_LINE_MAX];
+    uint8_t unit[BLOCK_SIZE];
+    size_t unit_len = 0;
+    size_t capacity = 0;
+    size_t used = 0;
+    bool success = true;
+
+    /* Block count is unknown until the end, grow the image while reading */
+    while (success && read_line(in, line, sizeof(line)))
+    {
+        size_t len = parse_hex(line, unit, sizeof(unit));
+        if (len == 0)
+            continue;
+        if (unit_len == 0)
+            unit_len = len;
+        if (len != unit_len || (len != BLOCK_SIZE && len != NTAG_PAGE_SIZE))
+        {
+            success = false;
+            break;
+        }
+        if (used + len > capacity)
+        {
+            capacity = capacity == 0 ? 64 * len : capacity * 2;
+            uint8_t *image = (uint8_t *)realloc(state.image, capacity);
+            if (image == NULL)
+            {
+                success = false;
+                break;
+            }
+            state.image = image;
+        }
+        memcpy(&state.image[used], unit, len);
+        used += len;
+    }
+
+    if (success && unit_len == BLOCK_SIZE)
+    {
+        state.family = CARD_MIFARE_CLASSIC;
+        success = dump_plan_classic_blocks(&state.plan, used / BLOCK_SIZE);
+    }
+    else if (success && unit_len == NTAG_PAGE_SIZE && used >= 2 * NTAG_PAGE_SIZE && used / NTAG_PAGE_SIZE <= 0xFF)
+    {
+        state.family = CARD_NTAG;
+        dump_plan_pages(&state.plan, "NTAG", CARD_NTAG, used / NTAG_PAGE_SIZE);
+    }
+    else
+    {
+        success = false;
+    }
+
+    if (success)
+    {
+        // Give back the unused tail of the last growth
+        uint8_t *image = (uint8_t *)realloc(state.image, used);
+        if (image != NULL)
+            state.image = image;
+        import_manufacturer_data(&state);
+    }
+    return import_finish(&state, success);
+}
+
+NFCTag *import_flipper(Stream *in)
+{
+    ImportState state;
+    char line[EXPORT_LINE_MAX];
+    uint8_t unit[BLOCK_SIZE];
+    bool success = true;
+
+    while (success && read_line(in, line, sizeof(line)))
+    {
+        char *separator = strstr(line, ": ");
+        if (line[0] == '#' || separator == NULL)
+            continue;
+        *separator = '\0';
+        const char *key = line;
+        const char *value = separator + 2;
+
+        if (strcmp(key, "Device type") == 0)
+        {
+            if (strcmp(value, "Mifare Classic") == 0)
+                state.family = CARD_MIFARE_CLASSIC;
+            else if (strcmp(value, "NTAG/Ultralight") == 0)
+                state.family = CARD_MIFARE_ULTRALIGHT;
+            else if (strcmp(value, "FeliCa") == 0)
+                state.felica = true;
+            else
+                success = false;
+        }
+        else if (strcmp(key, "UID") == 0)
+        {
+            state.uid_length = parse_hex(value, state.uid, sizeof(state.uid));
+        }
+        else if (strcmp(key, "ATQA") == 0)
+        {
+            uint8_t atqa[2] = {0};
+            parse_hex(value, atqa, sizeof(atqa));
+            state.atqa = (atqa[1] << 8) | atqa[0];
+        }
+        else if (strcmp(key, "SAK") == 0)
+        {
+            parse_hex(value, &state.sak, 1);
+        }
+        else if (strcmp(key, "Mifare Classic type") == 0)
+        {
+            state.blocks_count = strcmp(value, "MINI") == 0 ? 20 : strcmp(value, "2K") == 0 ? 128 : strcmp(value, "4K") == 0 ? 256 : 64;
+        }
+        else if (strcmp(key, "NTAG/Ultralight type") == 0)
+        {
+            if (strncmp(value, "NTAG", 4) == 0)
+                state.family = CARD_NTAG;
+            for (size_t i = 0; i < sizeof(flipper_types) / sizeof(flipper_types[0]); i++)
+            {
+                // First match, Flipper "Mifare Ultralight" stays plain Ultralight
+                if (state.name == NULL && strcmp(flipper_types[i].flipper, value) == 0)
+                    state.name = flipper_types[i].name;
+            }
+        }
+        else if (strcmp(key, "Pages total") == 0)
+        {
+            state.blocks_count = atoi(value);
+        }
+        else if (strcmp(key, "Manufacture id") == 0)
+        {
+            parse_hex(value, state.uid, 8);
+            state.uid_length = 8;
+        }
+        else if (strcmp(key, "Manufacture parameter") == 0)
+        {
+            parse_hex(value, state.pmm, 8);
+        }
+        else if (strcmp(key, "System code") == 0)
+        {
+            uint8_t code[2] = {0};
+            parse_hex(value, code, sizeof(code));
+            state.sys_code = (code[0] << 8) | code[1];
+        }
+        else if (strncmp(key, "Block ", 6) == 0 || strncmp(key, "Page ", 5) == 0)
+        {
+            size_t index = atoi(strchr(key, ' ') + 1);
+            size_t len = parse_hex(value, unit, sizeof(unit));
+            success = import_unit(&state, index, unit, len);
+        }
+    }
+    return import_finish(&state, success);
+}
+
+/* Minimal streaming JSON reader for the export_json layout */
+static int json_next(Stream *in)
+{
+    int c;
+    do
+    {
+        c = in->read();
+    } while (c == ' ' || c == '\n' || c == '\r' || c == '\t');
+    return c;
+}
+
+// Read a string whose opening quote was already consumed
+static bool json_string(Stream *in, char *out, size_t max_len)
+{
+    size_t len = 0;
+    int c = in->read();
+    while (c >= 0 && c != '"')
+    {
+        if (len < max_len - 1)
+            out[len++] = c;
+        c = in->read();
+    }
+    out[len] = '\0';
+    return c == '"';
+}
+
+NFCTag *import_json(Stream *in)
+{
+    ImportState state;
+    char key[16];
+    char value[EXPORT_LINE_MAX];
+    uint8_t unit[BLOCK_SIZE];
+    bool success = json_next(in) == '{';
+
+    while (success)
+    {
+        int c = json_next(in);
+        if (c == '}')
+            break;
+        if (c == ',')
+            continue;
+        if (c != '"' || !json_string(in, key, sizeof(key)) || json_next(in) != ':')
+        {
+            success = false;
+            break;
+        }
+
+        c = json_next(in);
+        if (c == '[')
+        {
+            /* Blocks array, decode each entry in place */
+            size_t index = 0;
+            c = json_next(in);
+            while (success && c == '"')
+            {
+                success = json_string(in, value, sizeof(value)) &&
+                          import_unit(&state, index++, unit, parse_hex(value, unit, sizeof(unit)));
+                c = json_next(in);
+                if (c == ',')
+                    c = json_next(in);
+            }
+            success = success && c == ']';
+        }
+        else if (c == '"')
+        {
+            success = json_string(in, value, sizeof(value));
+            if (strcmp(key, "type") == 0)
+            {
+                if (strcmp(value, "classic") == 0)
+                    state.family = CARD_MIFARE_CLASSIC;
+                else if (strcmp(value, "ultralight") == 0)
+                    state.family = CARD_MIFARE_ULTRALIGHT;
+                else if (strcmp(value, "ntag") == 0)
+                    state.family = CARD_NTAG;
+                else if (strcmp(value, "felica") == 0)
+                    state.felica = true;
+                else
+                    success = false;
+            }
+            else if (strcmp(key, "uid") == 0)
+            {
+                state.uid_length = parse_hex(value, state.uid, sizeof(state.uid));
+            }
+            else if (strcmp(key, "pmm") == 0)
+            {
+                parse_hex(value, state.pmm, sizeof(state.pmm));
+            }
+            else if (strcmp(key, "atqa") == 0 || strcmp(key, "sys_code") == 0)
+            {
+                uint8_t code[2] = {0};
+                parse_hex(value, code, sizeof(code));
+                if (key[0] == 'a')
+                    state.atqa = (code[0] << 8) | code[1];
+                else
+                    state.sys_code = (code[0] << 8) | code[1];
+            }
+            else if (strcmp(key, "sak") == 0)
+            {
+                parse_hex(value, &state.sak, 1);
+            }
+        }
+        else if (c >= '0' && c <= '9')
+        {
+            uint32_t number = c - '0';
+            while (in->peek() >= '0' && in->peek() <= '9')
+            {
+                number = number * 10 + (in->read() - '0');
+            }
+            if (strcmp(key, "blocks_count") == 0)
+                state.blocks_count = number;
+        }
+        else
+        {
+            success = false;
+        }
+    }
+    return import_finish(&state, success);
+}
@@ -0,0 +1,52 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NFC_EXPORT_H
+#define NFC_EXPORT_H
+
+#include <Arduino.h>
+#include "NFCTag.hpp"
+
+#define EXPORT_LINE_MAX 128     // Longest line accepted by line based importers
+
+/*
+    Dump serializers, blocks are written one at a time to out(Serial,
+    File, ...) so the whole text is never built in RAM.
+    Return the number of bytes written.
+*/
+// Raw binary image(.mfd for Classic, .bin for Ultralight/NTAG/FeliCa)
+size_t export_mfd(NFCTag *tag, Print *out);
+// Proxmark .eml, one hex line per block/page
+size_t export_eml(NFCTag *tag, Print *out);
+// Flipper Zero .nfc
+size_t export_flipper(NFCTag *tag, Print *out);
+// "classic", "ultralight", "ntag" or "felica", the JSON type field
+const char *export_type_name(NFCTag *tag);
+// Compact JSON: {"type":...,"uid":...,"blocks_count":N,"blocks":["hex",...]}
+size_t export_json(NFCTag *tag, Print *out);
+
+/*
+    Parsers, blocks are decoded straight into the buffer owned by the
+    returned NFCTag. Return NULL on malformed input.
+*/
+// size is the file size, it selects Classic Mini/1K/2K/4K or Ultralight/NTAG pages
+NFCTag *import_mfd(Stream *in, size_t size);
+NFCTag *import_eml(Stream *in);
+NFCTag *import_flipper(Stream *in);
+NFCTag *import_json(Stream *in);
+
+#endif
@@ -16,6 +16,7 @@
  */
 
 #include "nfc_framework.hpp"
+#include "NFCTag.hpp"
 #include "Arduino.h"
 #include <map>
 #include "BerTlv.h"
@@ -23,28 +24,215 @@
 NFCFramework::~NFCFramework()
 {
     LOG_INFO("Deleting NFC Framework");
+    delete iso_dep;
+    delete transport;
+    delete nfc;
 }
 
 bool NFCFramework::ready()
 {
-    return nfc->getFirmwareVersion();
+    return get_version() != 0;
+}
+
+uint32_t NFCFramework::get_version()
+{
+    uint8_t cmd[] = {PN532_COMMAND_GETFIRMWAREVERSION};
+    uint8_t response[4];
+    if (!ensure_awake())
+        return 0;
+    // IC, version, revision, supported card types
+    if (transport->command(cmd, sizeof(cmd), response, sizeof(response)) != sizeof(response))
+        return 0;
+    return ((uint32_t)response[0] << 24) | ((uint32_t)response[1] << 16) | (response[2] << 8) | response[3];
+}
+
+bool NFCFramework::power_down(uint8_t wakeup_sources)
+{
+    if (sleeping)
+        return true;
+    uint8_t cmd[] = {PN532_COMMAND_POWERDOWN, (uint8_t)(wakeup_sources | WAKEUP_HOST), 0x01};  // Raise IRQ on wake up
+    uint8_t status;
+    if (transport->command(cmd, sizeof(cmd), &status, 1) != 1 || (status & 0x3F) != 0)
+    {
+        LOG_ERROR("Failed to power down PN532\n");
+        return false;
+    }
+    sleeping = true;
+    return true;
+}
+
+bool NFCFramework::sam_config()
+{
+    uint8_t cmd[] = {PN532_COMMAND_SAMCONFIGURATION, 0x01, 0x14, 0x01};  // Normal mode, 1s timeout, use IRQ
+    uint8_t response[1];
+    if (transport->command(cmd, sizeof(cmd), response, sizeof(response)) < 0)
+    {
+        LOG_ERROR("Failed to configure PN532 SAM\n");
+        return false;
+    }
+    return true;
+}
+
+bool NFCFramework::wake_up()
+{
+    transport->wakeup();
+    sleeping = false;
+    return sam_config();
+}
+
+bool NFCFramework::ensure_awake()
+{
+    return !sleeping || wake_up();
+}
+
+void NFCFramework::presence_begin(PresenceConfig config)
+{
+    if (config.types_count == 0 || config.types_count > AUTOPOLL_MAX_TYPES)
+        config.types_count = 1;
+    if (config.polls == 0 || config.polls == 0xFF)  // 0xFF would poll forever
+        config.polls = 1;
+    if (config.power_down && !transport->has_irq())
+    {
+        // The next poll would wake it right away through the host interface
+        LOG_ERROR("PowerDown between polls needs the PN532 IRQ line\n");
+        config.power_down = false;
+    }
+    presence_config = config;
+    present_card = PresenceEvent();
+    pending_card = PresenceEvent();
+}
+
+bool NFCFramework::presence_poll(PresenceEvent *event)
+{
+    *event = PresenceEvent();
+    if (pending_card.type == PRESENCE_ARRIVED)
+    {
+        *event = pending_card;
+        present_card = pending_card;
+        pending_card = PresenceEvent();
+        return true;
+    }
+
+    uint8_t period = (presence_config.period + AUTOPOLL_PERIOD_UNIT / 2) / AUTOPOLL_PERIOD_UNIT;
+    if (period == 0)
+        period = 1;
+    else if (period > 0x0F)
+        period = 0x0F;
+
+    uint8_t cmd[3 + AUTOPOLL_MAX_TYPES] = {PN532_COMMAND_INAUTOPOLL, presence_config.polls, period};
+    memcpy(&cmd[3], presence_config.types, presence_config.types_count);
+    uint32_t window = (uint32_t)presence_config.polls * period * AUTOPOLL_PERIOD_UNIT * presence_config.types_count;
+    uint32_t timeout = window + PN532_DEFAULT_TIMEOUT;
+    if (timeout > 0xFFFF)
+        timeout = 0xFFFF;
+
+    /* Sleep through the poll window, the IRQ an RF wake up raises ends it early */
+    if (sleeping && transport->has_irq())
+        transport->wait_wakeup(window > 0xFFFF ? 0xFFFF : window);
+    if (!ensure_awake())
+        return false;
+
+    uint8_t response[64];
+    int16_t len = transport->command(cmd, 3 + presence_config.types_count, response, sizeof(response), timeout);
+    if (len < 1)
+        return false;
+
+    PresenceEvent found;
+    if (response[0] > 0 && len >= 3 && 3 + response[2] <= len)
+    {
+        /* First target only: Type, length, target data */
+        uint8_t type = response[1];
+        uint8_t *target = &response[3];
+        uint8_t target_len = response[2];
+        uint8_t uid_offset = 0;
+        found.card_type = type;
+        found.timestamp = millis();
+        switch (type)
+        {
+        case AUTOPOLL_GENERIC_106:
+        case AUTOPOLL_MIFARE:
+        case AUTOPOLL_ISO14443_4A:
+            // Tg, SENS_RES, SEL_RES, NFCID1 length, NFCID1
+            if (target_len >= 5 && target[4] <= target_len - 5)
+            {
+                uid_offset = 5;
+                found.uid_length = target[4];
+            }
+            break;
+        case AUTOPOLL_GENERIC_FELICA_212:
+        case AUTOPOLL_GENERIC_FELICA_424:
+        case AUTOPOLL_FELICA_212:
+        case AUTOPOLL_FELICA_424:
+            // Tg, POL_RES length, response code, IDm
+            uid_offset = 3;
+            found.uid_length = 8;
+            break;
+        case AUTOPOLL_GENERIC_TYPE_B:
+        case AUTOPOLL_ISO14443_4B:
+            // Tg, ATQB: 0x50, PUPI
+            uid_offset = 2;
+            found.uid_length = 4;
+            break;
+        case AUTOPOLL_JEWEL:
+            // Tg, SENS_RES, JEWELID
+            uid_offset = 3;
+            found.uid_length = 4;
+            break;
+        }
+        if (found.uid_length > sizeof(found.uid))
+            found.uid_length = sizeof(found.uid);
+        if (uid_offset != 0 && uid_offset + found.uid_length <= target_len)
+        {
+            memcpy(found.uid, &target[uid_offset], found.uid_length);
+            found.type = PRESENCE_ARRIVED;
+        }
+        else
+        {
+            LOG_ERROR("Unknown or short InAutoPoll target\n");
+        }
+    }
+
+    bool same_card = present_card.type == PRESENCE_ARRIVED && found.type == PRESENCE_ARRIVED &&
+                     present_card.uid_length == found.uid_length &&
+                     memcmp(present_card.uid, found.uid, found.uid_length) == 0;
+    if (same_card)
+        return false;
+
+    if (present_card.type == PRESENCE_ARRIVED)
+    {
+        /* Previous card left, report a possible new one on next call */
+        *event = present_card;
+        event->type = PRESENCE_REMOVED;
+        event->timestamp = millis();
+        pending_card = found;
+        present_card = PresenceEvent();
+    }
+    else if (found.type == PRESENCE_ARRIVED)
+    {
+        *event = found;
+        present_card = found;
+    }
+
+    if (present_card.type != PRESENCE_ARRIVED && pending_card.type != PRESENCE_ARRIVED && presence_config.power_down)
+        power_down(WAKEUP_RF);
+    return event->type != PRESENCE_NONE;
 }
 
 int NFCFramework::get_tag_uid(uint8_t *uid, uint8_t length)
 {
-    return nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &length);
+    return get_tag_uid(uid, &length);
 }
 
 int NFCFramework::get_tag_uid(uint8_t *uid, uint8_t *length)
 {
-    LOG_INFO("Getting NFC Framework");
-    return nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, length);
+    uint16_t atqa;
+    uint8_t sak;
+    return get_tag_uid(uid, length, &atqa, &sak);
 }
 
 int NFCFramework::get_tag_uid(uint8_t *uid, uint8_t *length, uint16_t *atqa, uint8_t *sak)
 {
-    LOG_INFO("Getting NFC Framework");
-    return nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, length, atqa, sak);
+    return select_tag(uid, length, atqa, sak);
 }
 
 void NFCFramework::print_block(int currentblock, uint8_t *block)
@@ -59,7 +247,8 @@ void NFCFramework::print_block(int currentblock, uint8_t *block)
     {
         SERIAL_DEVICE.print(" ");
     }
-    nfc->PrintHexChar(block, BLOCK_SIZE);
+    printHex(block, BLOCK_SIZE);
+    SERIAL_DEVICE.println();
 }
 
 void NFCFramework::print_error(int block_number, const char *reason)
@@ -74,217 +263,459 @@ uint8_t *NFCFramework::prepare_tag_store(uint8_t *tag_data, size_t tag_size)
     return tag_data;
 }
 
-bool NFCFramework::read_block(uint8_t block, uint8_t *key, KeyType key_type, uint8_t *out) {
-    Serial.println("Read1");
-    uint8_t uid[7] = {0};            // Buffer to store the returned UID
-    uint8_t uidLength = 0;           // Length of the UID (4 or 7 bytes depending on ISO14443A card type)
-    Serial.print("Block: ");
-    Serial.println(block);
-    Serial.print("Key: ");
-    for (size_t i = 0; i < 6; i++)
-    {
-        Serial.print(key[i], HEX);
-    }
-    Serial.println();
-    
-    if (nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength))
-    {
-            Serial.println("Read12");
-        if(nfc->mifareclassic_AuthenticateBlock(uid, uidLength, block, key_type, key)) {
-            Serial.println("Authentication successful!");   
-            return nfc->mifareclassic_ReadDataBlock(block, out);
-        } else {
-            Serial.println("Authentication failed!");
+bool NFCFramework::in_data_exchange(uint8_t *data, uint8_t data_len, uint8_t *response, uint8_t *response_len, uint16_t timeout)
+{
+    uint8_t cmd[PN532_FRAME_MAX - 8];
+    uint8_t answer[PN532_FRAME_MAX - 9];
+    if (data_len > sizeof(cmd) - 2 || !ensure_awake())
+        return false;
+    cmd[0] = PN532_COMMAND_INDATAEXCHANGE;
+    cmd[1] = 1; // First target
+    memcpy(&cmd[2], data, data_len);
+
+    int16_t len = transport->command(cmd, data_len + 2, answer, sizeof(answer), timeout);
+    if (len < 1 || (answer[0] & 0x3F) != 0)
+        return false;
+    len--;
+    if (len > *response_len)
+        len = *response_len;
+    memcpy(response, &answer[1], len);
+    *response_len = len;
+    return true;
+}
+
+bool NFCFramework::mifareclassic_read(uint8_t block, uint8_t *out)
+{
+    uint8_t cmd[] = {MIFARE_CMD_READ, block};
+    uint8_t len = BLOCK_SIZE;
+    return in_data_exchange(cmd, sizeof(cmd), out, &len) && len == BLOCK_SIZE;
+}
+
+bool NFCFramework::mifareclassic_write(uint8_t block, uint8_t *data)
+{
+    uint8_t cmd[2 + BLOCK_SIZE] = {MIFARE_CMD_WRITE, block};
+    uint8_t response[1];
+    uint8_t len = sizeof(response);
+    memcpy(&cmd[2], data, BLOCK_SIZE);
+    return in_data_exchange(cmd, sizeof(cmd), response, &len);
+}
+
+bool NFCFramework::mifareclassic_auth(DumpPlan *plan, uint8_t block, KeyType key_type, uint8_t *key)
+{
+    /* Authentication uses the last four bytes of the UID */
+    uint8_t cmd[12] = {(uint8_t)(key_type == KEY_A ? MIFARE_CMD_AUTH_A : MIFARE_CMD_AUTH_B), block};
+    uint8_t response[1];
+    uint8_t len = sizeof(response);
+    memcpy(&cmd[2], key, 6);
+    memcpy(&cmd[8], &plan->uid[plan->uid_length - 4], 4);
+    return in_data_exchange(cmd, sizeof(cmd), response, &len);
+}
+
+bool NFCFramework::select_tag(uint8_t *uid, uint8_t *uid_length, uint16_t *atqa, uint8_t *sak)
+{
+    uint8_t cmd[] = {PN532_COMMAND_INLISTPASSIVETARGET, 1, PN532_MIFARE_ISO14443A};
+    uint8_t response[20];
+    auth_sector = -1;
+    if (!ensure_awake())
+        return false;
+
+    /* NbTg, Tg, SENS_RES(2 bytes), SEL_RES, NFCID1 length, NFCID1 */
+    int16_t len = transport->command(cmd, sizeof(cmd), response, sizeof(response), 1000);
+    if (len < 6 || response[0] != 1 || response[5] > 7 || len < 6 + response[5])
+        return false;
+    *atqa = (response[2] << 8) | response[3];
+    *sak = response[4];
+    *uid_length = response[5];
+    memcpy(uid, &response[6], *uid_length);
+    return true;
+}
+
+bool NFCFramework::reselect_tag()
+{
+    uint8_t uid[7];
+    uint8_t uid_length;
+    uint16_t atqa;
+    uint8_t sak;
+    return select_tag(uid, &uid_length, &atqa, &sak);
+}
+
+bool NFCFramework::authenticate_sector(DumpPlan *plan, uint8_t sector, KeyType key_type, SectorKeys *keys)
+{
+    uint8_t key_mask = key_type == KEY_A ? ACCESS_KEY_A : ACCESS_KEY_B;
+    if (auth_sector == sector && auth_key == key_type)
+        return true;
+    if (!(key_type == KEY_A ? keys->has_key_a : keys->has_key_b) || (auth_state[sector].refused & key_mask))
+        return false;
+    if (!mifareclassic_auth(plan, classic_trailer_block(sector), key_type, key_type == KEY_A ? keys->key_a : keys->key_b))
+    {
+        auth_state[sector].refused |= key_mask;
+        reselect_tag();
+        return false;
+    }
+    auth_state[sector].proven |= key_mask;
+    auth_sector = sector;
+    auth_key = key_type;
+    return true;
+}
+
+int NFCFramework::learn_access(DumpPlan *plan, uint8_t sector, SectorKeys *keys, uint8_t *trailer)
+{
+    auth_state[sector].access_tried = true;
+    /* Key A can always read access bits, Key B only on some conditions */
+    if (!authenticate_sector(plan, sector, KEY_A, keys) && !authenticate_sector(plan, sector, KEY_B, keys))
+        return -1;
+    if (!mifareclassic_read(classic_trailer_block(sector), trailer))
+    {
+        reselect_tag();
+        return 0;
+    }
+    return mifare_access_decode(trailer, &access_cache[sector]) ? 1 : 0;
+}
+
+uint8_t NFCFramework::access_keys(DumpPlan *plan, uint16_t block, AccessOperation op, SectorKeys *keys)
+{
+    uint8_t sector = classic_sector_of(block);
+    uint8_t group = mifare_access_group(block - classic_first_block(sector), classic_sector_blocks(sector));
+    uint8_t trailer[BLOCK_SIZE];
+
+    if (!access_cache[sector].valid && !auth_state[sector].access_tried)
+        learn_access(plan, sector, keys, trailer);
+
+    uint8_t allowed = mifare_access_allowed(&access_cache[sector], group, op);
+    if (!keys->has_key_a)
+        allowed &= ~ACCESS_KEY_A;
+    if (!keys->has_key_b)
+        allowed &= ~ACCESS_KEY_B;
+    return allowed;
+}
+
+bool NFCFramework::authenticate_keys(DumpPlan *plan, uint8_t sector, uint8_t allowed, SectorKeys *keys)
+{
+    if (allowed == ACCESS_NEVER)
+        return false;
+
+    /* Keep the current authentication when it's good enough */
+    if (auth_sector == sector && (allowed & (auth_key == KEY_A ? ACCESS_KEY_A : ACCESS_KEY_B)))
+        return true;
+    if ((allowed & ACCESS_KEY_A) && authenticate_sector(plan, sector, KEY_A, keys))
+        return true;
+    return (allowed & ACCESS_KEY_B) && authenticate_sector(plan, sector, KEY_B, keys);
+}
+
+bool NFCFramework::authenticate_for(DumpPlan *plan, uint16_t block, AccessOperation op, SectorKeys *keys)
+{
+    return authenticate_keys(plan, classic_sector_of(block), access_keys(plan, block, op, keys), keys);
+}
+
+bool NFCFramework::ntag_read_pages(uint8_t page, uint8_t *out)
+{
+    uint8_t cmd[] = {MIFARE_CMD_READ, page};
+    uint8_t len = 4 * NTAG_PAGE_SIZE;
+    return in_data_exchange(cmd, sizeof(cmd), out, &len) && len == 4 * NTAG_PAGE_SIZE;
+}
+
+bool NFCFramework::ntag_write_page(uint8_t page, uint8_t *data)
+{
+    uint8_t cmd[2 + NTAG_PAGE_SIZE] = {MIFARE_ULTRALIGHT_CMD_WRITE, page};
+    uint8_t response[1];
+    uint8_t len = sizeof(response);
+    memcpy(&cmd[2], data, NTAG_PAGE_SIZE);
+    return in_data_exchange(cmd, sizeof(cmd), response, &len);
+}
+
+bool NFCFramework::ntag_read_byte(size_t offset, uint8_t *out, uint8_t *window, int *window_page)
+{
+    int page = offset / NTAG_PAGE_SIZE;
+    if (page < *window_page || page >= *window_page + 4)
+    {
+        if (page > 0xFF || !ntag_read_pages(page, window))
             return false;
-        }
+        *window_page = page;
     }
-    return false;
+    *out = window[offset - *window_page * NTAG_PAGE_SIZE];
+    return true;
+}
+
+bool NFCFramework::read_block(uint8_t block, uint8_t *key, KeyType key_type, uint8_t *out) {
+    if (!auth_tag(key, block, key_type))
+        return false;
+    return mifareclassic_read(block, out);
 };
 
+bool NFCFramework::read_block(uint8_t block, SectorKeys *keys, uint8_t *out)
+{
+    DumpPlan plan;
+    if (!plan_dump(&plan) || plan.family != CARD_MIFARE_CLASSIC)
+        return false;
+    if (!authenticate_for(&plan, block, ACCESS_READ, keys))
+    {
+        print_error(block, "Access conditions deny read.\n");
+        return false;
+    }
+    return mifareclassic_read(block, out);
+}
+
+uint8_t *NFCFramework::legacy_image(DumpPlan *plan, uint8_t *image)
+{
+    if (image == NULL)
+        return NULL;
+    bool paged = plan->family != CARD_MIFARE_CLASSIC;
+    size_t size = paged ? (size_t)plan->blocks * BLOCK_SIZE : dump_plan_image_size(plan);
+    size_t minimum = paged ? MIFARE_ULTRALIGHT_SIZE : MIFARE_CLASSIC_SIZE;
+    uint8_t *all_blocks = prepare_tag_store(NULL, size > minimum ? size : minimum);
+    if (!paged)
+    {
+        memcpy(all_blocks, image, size);
+    }
+    else
+    {
+        for (uint16_t page = 0; page < plan->blocks; page++)
+            memcpy(&all_blocks[page * BLOCK_SIZE], &image[page * NTAG_PAGE_SIZE], NTAG_PAGE_SIZE);
+    }
+    free(image);
+    return all_blocks;
+}
+
 uint8_t *NFCFramework::dump_tag(uint8_t key[], size_t *uid_length, DumpResult *result)
 {
-    // unreadable_sectors = 0;
-    // unauthenticated_sectors = 0;
+    DumpPlan plan;
     result->unreadable = 0;
     result->unauthenticated = 0;
-    uint8_t uid[7] = {0};            // Buffer to store the returned UID
-    uint8_t uidLength = 0;           // Length of the UID (4 or 7 bytes depending on ISO14443A card type)
-    uint8_t block[BLOCK_SIZE] = {0}; // Array to store each block during reads
-    uint8_t *all_blocks;             // Whole tag data
+    if (!plan_dump(&plan))
+        return NULL;
+    *uid_length = plan.uid_length;
+    if (plan.family != CARD_MIFARE_CLASSIC)
+        return legacy_image(&plan, dump_tag(&plan, (Key *)NULL, result));
+
+    /* Same Key A for every sector */
+    SectorKeys *keys = new SectorKeys[plan.sectors];
+    for (uint8_t sector = 0; sector < plan.sectors; sector++)
+    {
+        keys[sector].has_key_a = true;
+        memcpy(keys[sector].key_a, key, 6);
+    }
+    uint8_t *all_blocks = legacy_image(&plan, dump_tag(&plan, keys, result));
+    delete[] keys;
+    return all_blocks;
+}
 
-    // Wait for an ISO14443A type cards (Mifare, etc.).  When one is found
-    // 'uid' will be populated with the UID, and uidLength will indicate
-    // if the uid is 4 bytes (Mifare Classic) or 7 bytes (Mifare Ultralight)
+uint8_t* NFCFramework::dump_tag(Key* keys, uint8_t blocks, DumpResult *result)
+{
+    DumpPlan plan;
+    result->unreadable = 0;
+    result->unauthenticated = 0;
+    if (!plan_dump(&plan))
+        return NULL;
+    if (plan.family != CARD_MIFARE_CLASSIC)
+        return legacy_image(&plan, dump_tag(&plan, (Key *)NULL, result));
 
-    if (nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength))
+    /* keys has one entry every four blocks up to blocks, sectors past it have no key */
+    SectorKeys *sector_keys = new SectorKeys[plan.sectors];
+    for (uint8_t sector = 0; sector < plan.sectors; sector++)
     {
-        *uid_length = uidLength;
-        // Display some basic information about the card
-        SERIAL_DEVICE.printf("Found a new card!\n UID Length: %i\n UID Value: ", uidLength);
-        nfc->PrintHex(uid, uidLength);
-        SERIAL_DEVICE.println("");
+        uint16_t first = classic_first_block(sector);
+        if (first >= blocks)
+            break;
+        Key *key = &keys[first / 4];
+        sector_keys[sector].has_key_a = key->type == KEY_A;
+        sector_keys[sector].has_key_b = key->type == KEY_B;
+        memcpy(key->type == KEY_A ? sector_keys[sector].key_a : sector_keys[sector].key_b, key->data, 6);
+    }
+    uint8_t *all_blocks = legacy_image(&plan, dump_tag(&plan, sector_keys, result));
+    delete[] sector_keys;
+    return all_blocks;
+}
+
+bool NFCFramework::plan_dump(DumpPlan *plan)
+{
+    uint8_t uid[7] = {0};
+    uint8_t uidLength = 0;
+    uint16_t atqa = 0;
+    uint8_t sak = 0;
+    uint8_t version[GET_VERSION_SIZE];
+    uint8_t version_length = sizeof(version);
+    bool has_version = false;
+    bool ultralight_c = false;
 
-        if (MIFARE_IS_ULTRALIGHT(uidLength))
+    if (!select_tag(uid, &uidLength, &atqa, &sak))
+    {
+        SERIAL_DEVICE.println("Timeout");
+        return false;
+    }
+    if (sak == 0x00)
+    {
+        uint8_t cmd[] = {GET_VERSION_CMD};
+        has_version = in_data_exchange(cmd, sizeof(cmd), version, &version_length) && version_length == GET_VERSION_SIZE;
+        // Cards without GET_VERSION go back to idle
+        if (!has_version && !reselect_tag())
+            return false;
+        if (!has_version)
         {
-            SERIAL_DEVICE.println("Found Mifare Ultralight card!\n");
-            all_blocks = prepare_tag_store(all_blocks, MIFARE_ULTRALIGHT_SIZE);
+            /* Ultralight C answers the first AUTHENTICATE step, the original Ultralight doesn't */
+            uint8_t auth[] = {ULTRALIGHT_C_AUTH_CMD, 0x00};
+            uint8_t challenge[9];
+            uint8_t challenge_length = sizeof(challenge);
+            ultralight_c = in_data_exchange(auth, sizeof(auth), challenge, &challenge_length) &&
+                           challenge_length == sizeof(challenge) && challenge[0] == 0xAF;
+            // Drop the half done authentication or the NAK state
+            if (!reselect_tag())
+                return false;
         }
-        else
+    }
+    if (!dump_plan_build(atqa, sak, uid, uidLength, has_version ? version : NULL, plan))
+    {
+        LOG_ERROR("Unsupported tag\n");
+        return false;
+    }
+    if (ultralight_c && plan->family == CARD_MIFARE_ULTRALIGHT)
+    {
+        dump_plan_pages(plan, "Mifare Ultralight C", CARD_MIFARE_ULTRALIGHT, ULTRALIGHT_C_PAGES);
+        plan->hidden_units = ULTRALIGHT_C_KEY_PAGES;
+    }
+    auth_sector = -1;
+    for (uint8_t i = 0; i < MIFARE_CLASSIC_MAX_SECTORS; i++)
+    {
+        auth_state[i] = SectorAuthState();
+    }
+    if (memcmp(access_uid, plan->uid, sizeof(access_uid)) != 0)
+    {
+        // Another card, access conditions must be learnt again
+        memcpy(access_uid, plan->uid, sizeof(access_uid));
+        for (uint8_t i = 0; i < MIFARE_CLASSIC_MAX_SECTORS; i++)
         {
-            SERIAL_DEVICE.println("Found Mifare Classic card!\n");
-            all_blocks = prepare_tag_store(all_blocks, MIFARE_CLASSIC_SIZE);
+            access_cache[i] = SectorAccess();
         }
+    }
+    SERIAL_DEVICE.printf("Found %s: %i blocks of %i bytes\n", plan->name, plan->blocks, plan->unit_size);
+    return true;
+}
 
-        for (size_t currentblock = 0;
-             currentblock < (MIFARE_IS_ULTRALIGHT(uidLength) ? MIFARE_ULTRALIGHT_BLOCKS : MIFARE_CLASSIC_BLOCKS);
-             currentblock++)
+uint8_t *NFCFramework::dump_tag(DumpPlan *plan, Key *keys, DumpResult *result)
+{
+    result->unreadable = 0;
+    result->unauthenticated = 0;
+
+    if (plan->family != CARD_MIFARE_CLASSIC)
+    {
+        uint8_t *all_blocks = prepare_tag_store(NULL, dump_plan_image_size(plan));
+        uint8_t chunk[TYPE2_READ_SIZE];
+        uint16_t end = plan->blocks - plan->hidden_units;
+        if (end > TYPE2_MAX_PAGES)
         {
-            SERIAL_DEVICE.print("------------------------Sector ");
-            SERIAL_DEVICE.print(currentblock / 4, DEC);
-            SERIAL_DEVICE.println("-------------------------");
-            if (!MIFARE_IS_ULTRALIGHT(uidLength))
+            LOG_ERROR("Tag too big for READ addressing\n");
+            free(all_blocks);
+            return NULL;
+        }
+        for (uint16_t page = 0; page < end; page += plan->units_per_read)
+        {
+            uint8_t cmd[] = {plan->read_command, (uint8_t)page};
+            uint8_t len = sizeof(chunk);
+            uint8_t pages = end - page < plan->units_per_read ? end - page : plan->units_per_read;
+            if (in_data_exchange(cmd, sizeof(cmd), chunk, &len) && len == sizeof(chunk))
             {
-                if (nfc->mifareclassic_AuthenticateBlock(uid, uidLength, currentblock, 0, key))
-                {
-                    if (nfc->mifareclassic_ReadDataBlock(currentblock, block))
-                    {
-                        // Read successful
-                        memcpy(&all_blocks[currentblock * 16], block, sizeof(block)); // Store block in all_blocks array
-                        print_block(currentblock, &all_blocks[currentblock * 16]);    // Print block
-                    }
-                    else
-                    {
-                        result->unreadable++;
-                        print_error(currentblock, "Unable to read\n");
-                        memset(&all_blocks[currentblock * 16], -1, sizeof(block)); // Store block in all_blocks array
-                    }
-                }
-                else
-                {
-                    result->unauthenticated++;
-                    print_error(currentblock, "Unable to authenticate.\n");
-                    memset(&all_blocks[currentblock * 16], -1, sizeof(block)); // Store block in all_blocks array
-                };
+                memcpy(&all_blocks[page * plan->unit_size], chunk, pages * plan->unit_size);
             }
             else
             {
-                if (nfc->mifareultralight_ReadPage(currentblock, block))
-                {
-                    // Read successful
-                    print_block(currentblock, block);                             // Print block
-                    memcpy(&all_blocks[currentblock * 16], block, sizeof(block)); // Store block in all_blocks array
-                }
-                else
-                {
-                    result->unreadable++;
-                    print_error(currentblock, "Unable to read\n");
-                }
+                result->unreadable += pages;
+                print_error(page, "Unable to read\n");
+                reselect_tag();
             }
         }
-    }else {
-        SERIAL_DEVICE.println("Timeout");
-        return NULL;
+        return all_blocks;
     }
 
+    /* Classic cards go through the access bits aware engine with one key per sector */
+    SectorKeys *sector_keys = new SectorKeys[plan->sectors];
+    for (uint8_t sector = 0; sector < plan->sectors; sector++)
+    {
+        if (keys[sector].type == KEY_A)
+        {
+            sector_keys[sector].has_key_a = true;
+            memcpy(sector_keys[sector].key_a, keys[sector].data, 6);
+        }
+        else
+        {
+            sector_keys[sector].has_key_b = true;
+            memcpy(sector_keys[sector].key_b, keys[sector].data, 6);
+        }
+    }
+    uint8_t *all_blocks = dump_tag(plan, sector_keys, result);
+    delete[] sector_keys;
     return all_blocks;
 }
 
-uint8_t* NFCFramework::dump_tag(Key* keys, uint8_t blocks, DumpResult *result)
+uint8_t *NFCFramework::dump_tag(DumpPlan *plan, SectorKeys *keys, DumpResult *result)
 {
-    // unreadable_sectors = 0;
-    // unauthenticated_sectors = 0;
     result->unreadable = 0;
     result->unauthenticated = 0;
-    uint8_t uid[7] = {0};            // Buffer to store the returned UID
-    uint8_t uidLength = 0;           // Length of the UID (4 or 7 bytes depending on ISO14443A card type)
-    uint8_t block[BLOCK_SIZE] = {0}; // Array to store each block during reads
-    uint8_t *all_blocks;             // Whole tag data
-
-    // Wait for an ISO14443A type cards (Mifare, etc.).  When one is found
-    // 'uid' will be populated with the UID, and uidLength will indicate
-    // if the uid is 4 bytes (Mifare Classic) or 7 bytes (Mifare Ultralight)
+    if (plan->family != CARD_MIFARE_CLASSIC)
+        return dump_tag(plan, (Key *)NULL, result);
+    uint8_t *all_blocks = prepare_tag_store(NULL, dump_plan_image_size(plan));
 
-    if (nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength))
+    for (uint8_t sector = 0; sector < plan->sectors; sector++)
     {
-        // *uid_length = uidLength;
-        // Display some basic information about the card
-        SERIAL_DEVICE.printf("Found a new card!\n UID Length: %i\n UID Value: ", uidLength);
-        nfc->PrintHex(uid, uidLength);
-        SERIAL_DEVICE.println("");
+        uint16_t first = classic_first_block(sector);
+        uint16_t trailer = classic_trailer_block(sector);
+        uint8_t count = classic_sector_blocks(sector);
+        SectorKeys *sector_keys = &keys[sector];
+        SERIAL_DEVICE.printf("------------------------Sector %i-------------------------\n", sector);
 
-        if (MIFARE_IS_ULTRALIGHT(uidLength))
-        {
-            SERIAL_DEVICE.println("Found Mifare Ultralight card!\n");
-            all_blocks = prepare_tag_store(all_blocks, MIFARE_ULTRALIGHT_SIZE);
-            blocks = MIFARE_ULTRALIGHT_SIZE;
-        }
-        else
+        bool trailer_read = false;
+        if (!access_cache[sector].valid && !auth_state[sector].access_tried)
         {
-            SERIAL_DEVICE.println("Found Mifare Classic card!\n");
-            all_blocks = prepare_tag_store(all_blocks, MIFARE_CLASSIC_SIZE);
+            int learnt = learn_access(plan, sector, sector_keys, &all_blocks[trailer * BLOCK_SIZE]);
+            if (learnt < 0)
+            {
+                result->unauthenticated += count;
+                print_error(first, "Unable to authenticate.\n");
+                continue;
+            }
+            trailer_read = learnt > 0;
         }
 
-        for (size_t currentblock = 0;
-             currentblock < blocks;
-             currentblock++)
+        for (uint16_t block = first; block <= trailer; block++)
         {
-            SERIAL_DEVICE.print("------------------------Sector ");
-            SERIAL_DEVICE.print(currentblock / 4, DEC);
-            SERIAL_DEVICE.println("-------------------------");
-            if (!MIFARE_IS_ULTRALIGHT(uidLength))
+            uint8_t *out = &all_blocks[block * BLOCK_SIZE];
+            if (block == trailer && trailer_read)
             {
-                if (nfc->mifareclassic_AuthenticateBlock(uid, uidLength, currentblock, keys[currentblock / 4].type, keys[currentblock / 4].data))
-                {
-                    if (nfc->mifareclassic_ReadDataBlock(currentblock, block))
-                    {
-                        // Read successful
-                        memcpy(&all_blocks[currentblock * 16], block, sizeof(block)); // Store block in all_blocks array
-                        print_block(currentblock, &all_blocks[currentblock * 16]);    // Print block
-                    }
-                    else
-                    {
-                        result->unreadable++;
-                        print_error(currentblock, "Unable to read\n");
-                        memset(&all_blocks[currentblock * 16], 0, sizeof(block)); // Store block in all_blocks array
-                    }
-                }
-                else
-                {
-                    result->unauthenticated++;
-                    print_error(currentblock, "Unable to authenticate.\n");
-                    memset(&all_blocks[currentblock * 16], 0, sizeof(block)); // Store block in all_blocks array
-                };
+                print_block(block, out);
+                continue;
+            }
+            if (!authenticate_for(plan, block, ACCESS_READ, sector_keys))
+            {
+                // Denied by access bits or no valid key: nothing sent to the card
+                result->unauthenticated++;
+                print_error(block, "Access conditions deny read.\n");
+                continue;
+            }
+            if (mifareclassic_read(block, out))
+            {
+                print_block(block, out);
             }
             else
             {
-                if (nfc->mifareultralight_ReadPage(currentblock, block))
-                {
-                    // Read successful
-                    print_block(currentblock, block);                             // Print block
-                    memcpy(&all_blocks[currentblock * 16], block, sizeof(block)); // Store block in all_blocks array
-                }
-                else
-                {
-                    result->unreadable++;
-                    print_error(currentblock, "Unable to read\n");
-                }
+                result->unreadable++;
+                print_error(block, "Unable to read\n");
+                reselect_tag();
             }
         }
-    }else {
-        SERIAL_DEVICE.println("Timeout");
-        return NULL;
-    }
 
+        /* Key A is never readable and Key B only sometimes, fill in the ones the card accepted */
+        if (auth_state[sector].proven & ACCESS_KEY_A)
+            memcpy(&all_blocks[trailer * BLOCK_SIZE], sector_keys->key_a, 6);
+        if ((auth_state[sector].proven & ACCESS_KEY_B) && !mifare_access_key_b_readable(&access_cache[sector]))
+            memcpy(&all_blocks[trailer * BLOCK_SIZE + 10], sector_keys->key_b, 6);
+    }
     return all_blocks;
 }
 
 bool NFCFramework::auth_tag(uint8_t *key, uint8_t block_number, KeyType key_type)
 {
-    uint8_t uid[7] = {0}; // Buffer to store the returned UID
-    uint8_t uidLength;    // Length of the UID (4 or 7 bytes depending on ISO14443A card type)
-    if (nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength))
+    DumpPlan plan;
+    if (select_tag(plan.uid, &plan.uid_length, &plan.atqa, &plan.sak))
     {
-        if (nfc->mifareclassic_AuthenticateBlock(uid, uidLength, block_number, key_type, key))
+        if (mifareclassic_auth(&plan, block_number, key_type, key))
         {
             SERIAL_DEVICE.println("Key found!");
             return true;
@@ -299,34 +730,149 @@ bool NFCFramework::auth_tag(uint8_t *key, uint8_t block_number, KeyType key_type
 
 bool NFCFramework::write_tag(size_t block_number, uint8_t *data, uint8_t key_type, uint8_t *key)
 {
-    uint8_t uid[7] = {0}; // Buffer to store the returned UID
-    uint8_t uidLength;    // Length of the UID (4 or 7 bytes depending on ISO14443A card type)
-    if (nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength))
+    if (!auth_tag(key, block_number, (KeyType)key_type) || !mifareclassic_write(block_number, data))
+        return false;
+    forget_trailer(block_number);
+    return true;
+}
+
+bool NFCFramework::write_tag(size_t block_number, uint8_t *data, SectorKeys *keys)
+{
+    DumpPlan plan;
+    if (!plan_dump(&plan) || plan.family != CARD_MIFARE_CLASSIC)
+        return false;
+    if (!authenticate_for(&plan, block_number, ACCESS_WRITE, keys))
+    {
+        print_error(block_number, "Access conditions deny write.\n");
+        return false;
+    }
+    if (!mifareclassic_write(block_number, data))
+        return false;
+    forget_trailer(block_number);
+    return true;
+}
+
+void NFCFramework::forget_trailer(size_t block_number)
+{
+    uint8_t sector = classic_sector_of(block_number);
+    if (sector < MIFARE_CLASSIC_MAX_SECTORS && block_number == classic_trailer_block(sector))
+    {
+        // New keys and access bits, learn them again
+        access_cache[sector] = SectorAccess();
+        auth_state[sector] = SectorAuthState();
+    }
+}
+
+ValueStatus NFCFramework::run_value_operation(DumpPlan *plan, ValueOperation *operation, SectorKeys *keys)
+{
+    uint8_t sector = classic_sector_of(operation->block);
+    uint8_t block[BLOCK_SIZE];
+    uint8_t response[1];
+    uint8_t len = sizeof(response);
+
+    if (operation->block == classic_trailer_block(sector))
+        return VALUE_BAD_FORMAT;
+
+    if (operation->type == VALUE_READ)
+    {
+        if (!authenticate_for(plan, operation->block, ACCESS_READ, keys))
+            return VALUE_DENIED;
+        if (!mifareclassic_read(operation->block, block))
+            return VALUE_FAILED;
+        return mifare_value_decode(block, &operation->value, NULL) ? VALUE_OK : VALUE_BAD_FORMAT;
+    }
+    if (operation->type == VALUE_SET)
+    {
+        if (!authenticate_for(plan, operation->block, ACCESS_WRITE, keys))
+            return VALUE_DENIED;
+        uint8_t cmd[2 + BLOCK_SIZE] = {MIFARE_CMD_WRITE, operation->block};
+        mifare_value_encode(operation->value, operation->block, &cmd[2]);
+        return in_data_exchange(cmd, sizeof(cmd), response, &len) ? VALUE_OK : VALUE_FAILED;
+    }
+
+    /* Transfer buffer lives in the authenticated session, both blocks must be in one sector */
+    uint8_t destination = operation->transfer_block;
+    if (classic_sector_of(destination) != sector || destination == classic_trailer_block(sector))
+        return VALUE_BAD_FORMAT;
+
+    // One key must allow both the operation and the transfer
+    uint8_t allowed = access_keys(plan, destination, ACCESS_DECREMENT, keys);
+    if (operation->type == VALUE_INCREMENT)
+        allowed &= access_keys(plan, operation->block, ACCESS_INCREMENT, keys);
+    else
+        allowed &= access_keys(plan, operation->block, ACCESS_DECREMENT, keys);
+    if (!authenticate_keys(plan, sector, allowed, keys))
+        return VALUE_DENIED;
+
+    uint8_t cmd[6] = {MIFARE_CMD_STORE, operation->block};   // Restore
+    if (operation->type == VALUE_INCREMENT)
+        cmd[0] = MIFARE_CMD_INCREMENT;
+    else if (operation->type == VALUE_DECREMENT)
+        cmd[0] = MIFARE_CMD_DECREMENT;
+    if (operation->type != VALUE_RESTORE)
+    {
+        // Operand is a 4 bytes value, LSB first
+        cmd[2] = operation->value;
+        cmd[3] = operation->value >> 8;
+        cmd[4] = operation->value >> 16;
+        cmd[5] = operation->value >> 24;
+    }
+    if (!in_data_exchange(cmd, sizeof(cmd), response, &len))
+        return VALUE_FAILED;
+
+    uint8_t transfer[] = {MIFARE_CMD_TRANSFER, destination};
+    len = sizeof(response);
+    return in_data_exchange(transfer, sizeof(transfer), response, &len) ? VALUE_OK : VALUE_FAILED;
+}
+
+int NFCFramework::value_batch(ValueOperation *operations, size_t count, SectorKeys *keys)
+{
+    DumpPlan plan;
+    for (size_t i = 0; i < count; i++)
+        operations[i].status = VALUE_NOT_RUN;
+    if (!plan_dump(&plan) || plan.family != CARD_MIFARE_CLASSIC)
+        return -1;
+
+    int done = 0;
+    for (size_t i = 0; i < count; i++)
     {
-        if (nfc->mifareclassic_AuthenticateBlock(uid, uidLength, block_number, key_type, key))
+        ValueOperation *operation = &operations[i];
+        if (operation->block >= plan.blocks)
         {
-            return nfc->mifareclassic_WriteDataBlock(block_number, data);
+            operation->status = VALUE_BAD_FORMAT;
+            continue;
+        }
+        operation->status = run_value_operation(&plan, operation, &keys[classic_sector_of(operation->block)]);
+        if (operation->status == VALUE_OK)
+        {
+            done++;
+        }
+        else if (operation->status == VALUE_FAILED)
+        {
+            /* A refused command drops the card authentication, select it again for the next ones */
+            print_error(operation->block, "Value operation failed.\n");
+            if (!reselect_tag())
+                break;
         }
-    }else {
-        SERIAL_DEVICE.println("Timeout");
     }
-    return false;
+    return done;
 }
 
 uint8_t *NFCFramework::dump_ntag2xx_tag(size_t pages)
 {
     uint8_t uid[7] = {0};                                           // Buffer to store the returned UID
     uint8_t uidLength;                                              // Length of the UID (4 or 7 bytes depending on ISO14443A card type)
-    uint8_t *tag_data = prepare_tag_store(tag_data, pages * NTAG_PAGE_SIZE); // Container for all sectors
+    uint16_t atqa;
+    uint8_t sak;
 
-    if (nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength))
+    if (select_tag(uid, &uidLength, &atqa, &sak))
     {
         SERIAL_DEVICE.println("Found an ISO14443A card");
         SERIAL_DEVICE.print("  UID Length: ");
         SERIAL_DEVICE.print(uidLength, DEC);
         SERIAL_DEVICE.println(" bytes");
         SERIAL_DEVICE.print("  UID Value: ");
-        nfc->PrintHex(uid, uidLength);
+        printHex(uid, uidLength);
         SERIAL_DEVICE.println("");
         if (uidLength != 7)
         {
@@ -335,29 +881,31 @@ uint8_t *NFCFramework::dump_ntag2xx_tag(size_t pages)
         }
         else
         {
-            uint8_t data[NTAG_PAGE_SIZE];
+            uint8_t *tag_data = prepare_tag_store(NULL, pages * NTAG_PAGE_SIZE); // Container for all sectors
+            uint8_t data[4 * NTAG_PAGE_SIZE];
 
             LOG_INFO("Probably a ntag2xx tag");
-            for (uint8_t i = 0; i < pages; i++)
+            for (size_t i = 0; i < pages && i <= 0xFF; i += 4)
             {
-                // if (nfc->ntag2xx_ReadPage(i, data))
-                // {
-                //     // Read successfully
-                //     memcpy(&tag_data[i * NTAG_PAGE_SIZE], data, sizeof(data));
-                // }
-                // else
-                // {
-                //     memset(&tag_data[i * NTAG_PAGE_SIZE], -1, sizeof(data)); // Store block in all_blocks array
-                //     LOG_ERROR("Failed to read page");
-                // }
+                size_t count = pages - i < 4 ? pages - i : 4;
+                if (ntag_read_pages(i, data))
+                {
+                    // Read successfully
+                    memcpy(&tag_data[i * NTAG_PAGE_SIZE], data, count * NTAG_PAGE_SIZE);
+                }
+                else
+                {
+                    memset(&tag_data[i * NTAG_PAGE_SIZE], -1, count * NTAG_PAGE_SIZE); // Store block in all_blocks array
+                    LOG_ERROR("Failed to read page");
+                    reselect_tag();
+                }
             }
+            return tag_data;
         }
     }else {
         SERIAL_DEVICE.println("Timeout");
         return NULL;
     }
-
-    return tag_data;
 }
 
 bool NFCFramework::write_ntag2xx_page(size_t page, uint8_t *data)
@@ -366,14 +914,14 @@ bool NFCFramework::write_ntag2xx_page(size_t page, uint8_t *data)
     uint8_t uidLength;    // Length of the UID (4 or 7 bytes depending on ISO14443A card type)
     uint16_t atqa;
     uint8_t sak;
-    if (nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength))
+    if (select_tag(uid, &uidLength, &atqa, &sak))
     {
         SERIAL_DEVICE.println("Found an ISO14443A card");
         SERIAL_DEVICE.print("  UID Length: ");
         Serial.print(uidLength, DEC);
         Serial.println(" bytes");
         SERIAL_DEVICE.print("  UID Value: ");
-        nfc->PrintHex(uid, uidLength);
+        printHex(uid, uidLength);
         SERIAL_DEVICE.println("");
         if (uidLength != 7)
         {
@@ -382,7 +930,7 @@ bool NFCFramework::write_ntag2xx_page(size_t page, uint8_t *data)
         else
         {
             LOG_INFO("Probably a ntag2xx tag");
-            return nfc->mifareultralight_WritePage(page, data);
+            return ntag_write_page(page, data);
         }
     }else {
         SERIAL_DEVICE.println("Timeout");
@@ -391,6 +939,486 @@ bool NFCFramework::write_ntag2xx_page(size_t page, uint8_t *data)
     return false;
 }
 
+int NFCFramework::ndef_read(uint8_t *message, size_t max_len)
+{
+    uint8_t window[4 * NTAG_PAGE_SIZE]; // Last four pages read
+    int window_page = -1;
+
+    if (!reselect_tag())
+    {
+        SERIAL_DEVICE.println("Timeout");
+        return -1;
+    }
+
+    /* Capability container read brings also the first 12 bytes of the data area */
+    if (!ntag_read_pages(NDEF_CC_PAGE, window))
+        return -1;
+    window_page = NDEF_CC_PAGE;
+    if (window[0] != NDEF_CC_MAGIC)
+    {
+        LOG_ERROR("Tag isn't NDEF formatted\n");
+        return -1;
+    }
+    size_t end = NDEF_DATA_PAGE * NTAG_PAGE_SIZE + window[2] * 8;
+
+    auto read_byte = [&](size_t offset, uint8_t *out) -> bool {
+        return ntag_read_byte(offset, out, window, &window_page);
+    };
+
+    size_t offset = NDEF_DATA_PAGE * NTAG_PAGE_SIZE;
+    while (offset < end)
+    {
+        uint8_t tlv, byte;
+        if (!read_byte(offset++, &tlv))
+            return -1;
+        if (tlv == NDEF_TLV_NULL)
+            continue;
+        if (tlv == NDEF_TLV_TERMINATOR)
+            break;
+
+        /* One byte length or 0xFF followed by two bytes length */
+        if (!read_byte(offset++, &byte))
+            return -1;
+        size_t len = byte;
+        if (byte == 0xFF)
+        {
+            uint8_t low;
+            if (!read_byte(offset, &byte) || !read_byte(offset + 1, &low))
+                return -1;
+            len = (byte << 8) | low;
+            offset += 2;
+        }
+
+        if (tlv != NDEF_TLV_MESSAGE)
+        {
+            offset += len;
+            continue;
+        }
+        if (len > max_len || offset + len > end)
+        {
+            LOG_ERROR("NDEF message too big\n");
+            return -1;
+        }
+        for (size_t i = 0; i < len; i++)
+        {
+            if (!read_byte(offset + i, &message[i]))
+                return -1;
+        }
+        return len;
+    }
+    LOG_INFO("No NDEF message found\n");
+    return -1;
+}
+
+bool NFCFramework::ndef_write(NDEFRecord *records, size_t count)
+{
+    uint8_t window[4 * NTAG_PAGE_SIZE]; // Last four pages read
+    int window_page = NDEF_CC_PAGE;
+
+    if (!reselect_tag())
+    {
+        SERIAL_DEVICE.println("Timeout");
+        return false;
+    }
+    if (!ntag_read_pages(NDEF_CC_PAGE, window))
+        return false;
+    if (window[0] != NDEF_CC_MAGIC || (window[3] & 0xF0) != 0)
+    {
+        LOG_ERROR("Tag isn't NDEF writable\n");
+        return false;
+    }
+    size_t end = NDEF_DATA_PAGE * NTAG_PAGE_SIZE + window[2] * 8;
+
+    /*
+        Lock and Memory Control TLVs(e.g. the one of Ultralight C) describe
+        the tag memory and must stay in front of the message, which starts
+        right after the last of them
+    */
+    size_t start = NDEF_DATA_PAGE * NTAG_PAGE_SIZE;
+    size_t offset = start;
+    while (offset < end)
+    {
+        uint8_t tlv, len;
+        if (!ntag_read_byte(offset, &tlv, window, &window_page))
+            return false;
+        if (tlv == NDEF_TLV_NULL)
+        {
+            offset++;
+            continue;
+        }
+        if (tlv != NDEF_TLV_LOCK_CONTROL && tlv != NDEF_TLV_MEMORY_CONTROL)
+            break;
+        if (!ntag_read_byte(offset + 1, &len, window, &window_page))
+            return false;
+        offset += 2 + len;
+        start = offset;
+    }
+
+    size_t message_len = ndef_message_length(records, count);
+    size_t tlv_len = 1 + (message_len < 0xFF ? 1 : 3) + message_len + 1;  // Type, length, value, terminator
+    // WRITE addresses 256 pages, farther ones would need a sector select
+    size_t last_page = (start + tlv_len - 1) / NTAG_PAGE_SIZE;
+    if (start + tlv_len > end || last_page > 0xFF)
+    {
+        LOG_ERROR("NDEF message too big\n");
+        return false;
+    }
+
+    /*
+        Stream the TLV page by page, nothing after the terminator is touched.
+        Pages holding the length go with a zero length and get the real one
+        last, so an interrupted write leaves an empty message, not a broken one
+    */
+    size_t length_first = start + (message_len < 0xFF ? 1 : 2);
+    size_t length_last = start + (message_len < 0xFF ? 1 : 3);
+    uint16_t length_page = length_first / NTAG_PAGE_SIZE;
+    uint8_t length_pages[2][NTAG_PAGE_SIZE];
+    uint8_t page_data[NTAG_PAGE_SIZE];
+    uint8_t fill = 0;
+    uint16_t page = start / NTAG_PAGE_SIZE;
+    bool success = true;
+
+    // Bytes of the first page in front of the message are written back as they are
+    for (; fill < start % NTAG_PAGE_SIZE; fill++)
+    {
+        if (!ntag_read_byte(page * NTAG_PAGE_SIZE + fill, &page_data[fill], window, &window_page))
+            return false;
+    }
+
+    auto emit = [&](uint8_t byte) {
+        page_data[fill++] = byte;
+        if (fill == NTAG_PAGE_SIZE)
+        {
+            if (page >= length_page && page <= length_last / NTAG_PAGE_SIZE)
+            {
+                memcpy(length_pages[page - length_page], page_data, NTAG_PAGE_SIZE);
+                for (uint8_t i = 0; i < NTAG_PAGE_SIZE; i++)
+                {
+                    size_t at = page * NTAG_PAGE_SIZE + i;
+                    if (at >= length_first && at <= length_last)
+                        page_data[i] = 0;
+                }
+            }
+            success = success && page <= last_page && ntag_write_page(page++, page_data);
+            fill = 0;
+        }
+    };
+
+    emit(NDEF_TLV_MESSAGE);
+    if (message_len < 0xFF)
+    {
+        emit(message_len);
+    }
+    else
+    {
+        emit(0xFF);
+        emit(message_len >> 8);
+        emit(message_len);
+    }
+    ndef_encode_message(records, count, emit);
+    emit(NDEF_TLV_TERMINATOR);
+    while (fill != 0)
+    {
+        emit(NDEF_TLV_NULL);
+    }
+
+    // Low byte first when the length spans two pages, a half written one is never longer than the message
+    for (int i = length_last / NTAG_PAGE_SIZE; success && i >= length_page; i--)
+    {
+        success = ntag_write_page(i, length_pages[i - length_page]);
+    }
+    return success;
+}
+
+int NFCFramework::felica_ndef_read(uint8_t *message, size_t max_len)
+{
+    uint8_t idm[8];
+    uint8_t pmm[8];
+    uint16_t response_code;
+    uint16_t service = FELICA_NDEF_SERVICE_READ;
+    uint16_t block_list[FELICA_MAX_BLOCKS_PER_READ];
+    uint8_t blocks[FELICA_MAX_BLOCKS_PER_READ][16];
+
+    if (felica_polling(NDEF, idm, pmm, &response_code) != 1)
+        return -1;
+
+    /* Block 0 is the attribute information block */
+    block_list[0] = 0x8000;
+    if (felica_transfer(FELICA_CMD_READ_WITHOUT_ENCRYPTION, 1, &service, 1, block_list, blocks) != 1)
+        return -1;
+    uint16_t checksum = 0;
+    for (uint8_t i = 0; i < 14; i++)
+    {
+        checksum += blocks[0][i];
+    }
+    if (checksum != ((blocks[0][14] << 8) | blocks[0][15]))
+    {
+        LOG_ERROR("Invalid NDEF attribute block\n");
+        return -1;
+    }
+    uint8_t nbr = blocks[0][1];
+    if (nbr == 0 || nbr > FELICA_MAX_BLOCKS_PER_READ)
+        nbr = FELICA_MAX_BLOCKS_PER_READ;
+    size_t len = ((size_t)blocks[0][11] << 16) | (blocks[0][12] << 8) | blocks[0][13];
+    size_t count = (len + 15) / 16;
+    // Two bytes block list elements can address only 255 data blocks
+    if (len > max_len || count > 0xFF)
+    {
+        LOG_ERROR("NDEF message too big\n");
+        return -1;
+    }
+
+    /* Read as many blocks per command as the card allows */
+    for (size_t block = 0; block < count; block += nbr)
+    {
+        uint8_t n = count - block < nbr ? count - block : nbr;
+        for (uint8_t i = 0; i < n; i++)
+        {
+            block_list[i] = 0x8000 | (block + 1 + i);
+        }
+        if (felica_transfer(FELICA_CMD_READ_WITHOUT_ENCRYPTION, 1, &service, n, block_list, blocks) != 1)
+            return -1;
+        for (uint8_t i = 0; i < n; i++)
+        {
+            size_t offset = (block + i) * 16;
+            memcpy(&message[offset], blocks[i], len - offset < 16 ? len - offset : 16);
+        }
+    }
+    return len;
+}
+
+bool NFCFramework::felica_select(uint16_t system_code, uint8_t *idm, uint8_t *pmm)
+{
+    uint8_t cmd[] = {PN532_COMMAND_INLISTPASSIVETARGET, 1, 0x01, FELICA_CMD_POLLING, (uint8_t)(system_code >> 8), (uint8_t)system_code, 0x00, 0x00};
+    uint8_t response[24];
+    if (!ensure_awake())
+        return false;
+
+    /* NbTg, Tg, POL_RES length, response code, IDm, PMm */
+    int16_t len = transport->command(cmd, sizeof(cmd), response, sizeof(response), 1000);
+    if (len < 20 || response[0] != 1)
+        return false;
+    memcpy(idm, &response[4], 8);
+    memcpy(pmm, &response[12], 8);
+    return true;
+}
+
+/* Maximum response time from PMm: T x ((B + 1) x n + A + 1) x 4^E, T is about 302us */
+static uint16_t felica_timeout(uint8_t parameter, uint8_t n)
+{
+    uint32_t a = parameter & 0x07;
+    uint32_t b = (parameter >> 3) & 0x07;
+    uint32_t e = parameter >> 6;
+    uint32_t time = (302 * ((b + 1) * n + a + 1) << (2 * e)) / 1000;
+    return time + PN532_DEFAULT_TIMEOUT;
+}
+
+uint8_t NFCFramework::felica_pack(FelicaBlock *blocks, uint16_t *order, size_t count, uint8_t max_blocks, bool with_data)
+{
+    uint16_t services[FELICA_MAX_SERVICES];
+    uint8_t services_count = 0;
+    size_t size = 12;   // Length, command code, IDm, services count, blocks count
+    uint8_t n = 0;
+
+    while (n < count && n < max_blocks)
+    {
+        FelicaBlock *block = &blocks[order[n]];
+        uint8_t i = 0;
+        while (i < services_count && services[i] != block->service)
+            i++;
+        size_t needed = (block->block > 0xFF ? 3 : 2) + (with_data ? 16 : 0) + (i == services_count ? 2 : 0);
+        if (size + needed > FELICA_FRAME_MAX || (i == services_count && services_count == FELICA_MAX_SERVICES))
+            break;
+        if (i == services_count)
+            services[services_count++] = block->service;
+        size += needed;
+        n++;
+    }
+    return n;
+}
+
+bool NFCFramework::felica_exchange(uint8_t command, uint8_t *idm, uint8_t *pmm, FelicaBlock *blocks, uint16_t *order, uint8_t n, uint8_t out[][16])
+{
+    uint16_t services[FELICA_MAX_SERVICES];
+    uint8_t indexes[FELICA_MAX_BLOCKS_PER_READ];
+    uint8_t services_count = 0;
+    uint8_t frame[FELICA_FRAME_MAX];
+    uint8_t response[FELICA_FRAME_MAX];
+    uint8_t len = sizeof(response);
+    bool write = command == FELICA_CMD_WRITE_WITHOUT_ENCRYPTION;
+
+    for (uint8_t j = 0; j < n; j++)
+    {
+        uint16_t service = blocks[order[j]].service;
+        uint8_t i = 0;
+        while (i < services_count && services[i] != service)
+            i++;
+        if (i == services_count)
+            services[services_count++] = service;
+        indexes[j] = i;
+    }
+
+    /* Length, command, IDm, services(LSB first), block list, write data */
+    size_t pos = 1;
+    frame[pos++] = command;
+    memcpy(&frame[pos], idm, 8);
+    pos += 8;
+    frame[pos++] = services_count;
+    for (uint8_t i = 0; i < services_count; i++)
+    {
+        frame[pos++] = services[i];
+        frame[pos++] = services[i] >> 8;
+    }
+    frame[pos++] = n;
+    for (uint8_t j = 0; j < n; j++)
+    {
+        uint16_t number = blocks[order[j]].block;
+        if (number > 0xFF)
+        {
+            // Three bytes element for block numbers above 255
+            frame[pos++] = indexes[j];
+            frame[pos++] = number;
+            frame[pos++] = number >> 8;
+        }
+        else
+        {
+            frame[pos++] = 0x80 | indexes[j];
+            frame[pos++] = number;
+        }
+    }
+    if (write)
+    {
+        for (uint8_t j = 0; j < n; j++)
+        {
+            memcpy(&frame[pos], blocks[order[j]].data, 16);
+            pos += 16;
+        }
+    }
+    frame[0] = pos;
+
+    uint16_t timeout = felica_timeout(pmm[write ? FELICA_PMM_WRITE_TIME : FELICA_PMM_READ_TIME], n);
+    if (!in_data_exchange(frame, pos, response, &len, timeout))
+        return false;
+
+    /* Length, response code, IDm, status flag 1 and 2, then blocks count and data for reads */
+    if (len < 12 || response[1] != command + 1 || response[10] != 0)
+        return false;
+    if (write)
+        return true;
+    if (len < 13 + 16 * n || response[12] != n)
+        return false;
+    memcpy(out, &response[13], 16 * n);
+    return true;
+}
+
+bool NFCFramework::felica_write_blocks(FelicaBlock *blocks, size_t count, FelicaWriteResult *result)
+{
+    uint8_t idm[8];
+    uint8_t pmm[8];
+    *result = FelicaWriteResult();
+    if (count == 0)
+        return true;
+    if (!felica_select(DEFAULT_SYSTEM_CODE, idm, pmm))
+        return false;
+    return felica_write_blocks(idm, pmm, blocks, count, result);
+}
+
+bool NFCFramework::felica_write_blocks(uint8_t *idm, uint8_t *pmm, FelicaBlock *blocks, size_t count, FelicaWriteResult *result)
+{
+    uint8_t current[FELICA_MAX_BLOCKS_PER_READ][16];
+    *result = FelicaWriteResult();
+    if (count == 0)
+        return true;
+
+    /* Lite cards take a single block per write and four per read */
+    bool lite = pmm[1] == FELICA_IC_LITE || pmm[1] == FELICA_IC_LITE_S;
+    uint8_t max_read = lite ? FELICA_LITE_MAX_READ : FELICA_MAX_BLOCKS_PER_READ;
+    uint8_t max_write = lite ? FELICA_LITE_MAX_WRITE : FELICA_MAX_BLOCKS_PER_WRITE;
+    uint16_t *all = new uint16_t[count];
+    uint16_t *changed = new uint16_t[count];
+    for (size_t i = 0; i < count; i++)
+    {
+        all[i] = i;
+    }
+
+    /* Compare with the card, blocks that can't be read are written anyway */
+    for (size_t i = 0; i < count;)
+    {
+        uint8_t n = felica_pack(blocks, &all[i], count - i, max_read, false);
+        bool read = felica_exchange(FELICA_CMD_READ_WITHOUT_ENCRYPTION, idm, pmm, blocks, &all[i], n, current);
+        for (uint8_t j = 0; j < n; j++)
+        {
+            if (!read || memcmp(current[j], blocks[all[i + j]].data, 16) != 0)
+                changed[result->changed++] = all[i + j];
+        }
+        i += n;
+    }
+
+    for (size_t i = 0; i < result->changed;)
+    {
+        uint8_t n = felica_pack(blocks, &changed[i], result->changed - i, max_write, true);
+        result->frames++;
+        if (felica_exchange(FELICA_CMD_WRITE_WITHOUT_ENCRYPTION, idm, pmm, blocks, &changed[i], n, NULL))
+            result->written += n;
+        else
+            LOG_ERROR("FeliCa write failed\n");
+        i += n;
+    }
+
+    /* Read back only what was written */
+    for (size_t i = 0; i < result->changed;)
+    {
+        uint8_t n = felica_pack(blocks, &changed[i], result->changed - i, max_read, false);
+        if (felica_exchange(FELICA_CMD_READ_WITHOUT_ENCRYPTION, idm, pmm, blocks, &changed[i], n, current))
+        {
+            for (uint8_t j = 0; j < n; j++)
+            {
+                if (memcmp(current[j], blocks[changed[i + j]].data, 16) == 0)
+                    result->verified++;
+            }
+        }
+        i += n;
+    }
+
+    delete[] all;
+    delete[] changed;
+    return result->verified == result->changed;
+}
+
+bool NFCFramework::felica_restore(NFCTag *tag, FelicaWriteResult *result, const uint16_t *services)
+{
+    FelicaBlock blocks[FELICA_DUMP_BLOCKS];
+    uint8_t idm[8];
+    uint8_t pmm[8];
+    *result = FelicaWriteResult();
+    if (!tag->is_felica())
+        return false;
+    if (services == NULL)
+    {
+        /* S_PAD0-13 layout is only known for Lite cards */
+        uint8_t image_ic = tag->get_pmm()[1];
+        if (image_ic != FELICA_IC_LITE && image_ic != FELICA_IC_LITE_S)
+        {
+            LOG_ERROR("Not a FeliCa Lite image, services are needed\n");
+            return false;
+        }
+    }
+    if (!felica_select(DEFAULT_SYSTEM_CODE, idm, pmm))
+        return false;
+    if (services == NULL && pmm[1] != FELICA_IC_LITE && pmm[1] != FELICA_IC_LITE_S)
+    {
+        LOG_ERROR("Not a FeliCa Lite card, services are needed\n");
+        return false;
+    }
+    for (uint8_t i = 0; i < FELICA_DUMP_BLOCKS; i++)
+    {
+        blocks[i].service = services == NULL ? FELICA_LITE_SERVICE_RW : services[i];
+        blocks[i].block = i;
+        tag->get_block(i, blocks[i].data);
+    }
+    return felica_write_blocks(idm, pmm, blocks, FELICA_DUMP_BLOCKS, result);
+}
+
 void NFCFramework::fill_JIS_system_code(uint8_t *out)
 {
     int j = 0;
@@ -402,35 +1430,60 @@ void NFCFramework::fill_JIS_system_code(uint8_t *out)
 
 int NFCFramework::felica_polling(uint8_t *idm, uint8_t *pmm, uint16_t *response_code)
 {
-    int polling_result = nfc->felica_Polling(DEFAULT_SYSTEM_CODE, DEFAULT_REQUEST_CODE, idm, pmm, response_code, 65535);
-    if (polling_result < 0)
-    {
-        LOG_ERROR("Failed to poll with result: ");
-        SERIAL_DEVICE.println(polling_result);
-    }
-    return polling_result;
+    return felica_polling(DEFAULT_SYSTEM_CODE, DEFAULT_REQUEST_CODE, idm, pmm, response_code);
+}
+
+int NFCFramework::felica_polling(uint16_t system_code, uint8_t *idm, uint8_t *pmm, uint16_t *response_code)
+{
+    return felica_polling(system_code, DEFAULT_REQUEST_CODE, idm, pmm, response_code);
 }
 
-int NFCFramework::felica_polling(uint8_t system_code, uint8_t *idm, uint8_t *pmm, uint16_t *response_code)
+int NFCFramework::felica_polling(uint16_t system_code, uint8_t request_code, uint8_t *idm, uint8_t *pmm, uint16_t *response_code)
 {
-    int polling_result = nfc->felica_Polling(system_code, DEFAULT_REQUEST_CODE, idm, pmm, response_code, 65535);
+    uint8_t cmd[] = {PN532_COMMAND_INLISTPASSIVETARGET, 1, 0x01, FELICA_CMD_POLLING, (uint8_t)(system_code >> 8), (uint8_t)system_code, request_code, 0x00};
+    uint8_t response[24];
+    if (!ensure_awake())
+        return -1;
+
+    /* NbTg, Tg, POL_RES length, response code, IDm, PMm, request data */
+    int16_t polling_result = transport->command(cmd, sizeof(cmd), response, sizeof(response), FELICA_POLLING_TIMEOUT);
     if (polling_result < 0)
     {
         LOG_ERROR("Failed to poll with result: ");
         SERIAL_DEVICE.println(polling_result);
+        return polling_result;
     }
-    return polling_result;
+    if (polling_result < 20 || response[0] != 1)
+        return 0;
+    memcpy(idm, &response[4], 8);
+    memcpy(pmm, &response[12], 8);
+    *response_code = polling_result >= 22 ? (response[20] << 8) | response[21] : 0;
+    // Read/Write Without Encryption address the last polled card
+    memcpy(felica_idm, idm, 8);
+    memcpy(felica_pmm, pmm, 8);
+    return 1;
 }
 
-int NFCFramework::felica_polling(uint8_t system_code, uint8_t request_code, uint8_t *idm, uint8_t *pmm, uint16_t *response_code)
+int NFCFramework::felica_transfer(uint8_t command, uint8_t service_codes_list_length, uint16_t *service_codes, uint8_t block_number, uint16_t *block_list, uint8_t data[][16])
 {
-    int polling_result = nfc->felica_Polling(system_code, request_code, idm, pmm, response_code, 65535);
-    if (polling_result < 0)
+    FelicaBlock blocks[FELICA_MAX_BLOCKS_PER_READ];
+    uint16_t order[FELICA_MAX_BLOCKS_PER_READ];
+    if (block_number == 0 || block_number > FELICA_MAX_BLOCKS_PER_READ)
+        return -1;
+
+    /* Two bytes block list elements: 0x80 | service index, block number */
+    for (uint8_t i = 0; i < block_number; i++)
     {
-        LOG_ERROR("Failed to poll with result: ");
-        SERIAL_DEVICE.println(polling_result);
+        uint8_t service = (block_list[i] >> 8) & 0x0F;
+        if (service >= service_codes_list_length)
+            return -1;
+        blocks[i].service = service_codes[service];
+        blocks[i].block = block_list[i] & 0xFF;
+        if (command == FELICA_CMD_WRITE_WITHOUT_ENCRYPTION)
+            memcpy(blocks[i].data, data[i], 16);
+        order[i] = i;
     }
-    return polling_result;
+    return felica_exchange(command, felica_idm, felica_pmm, blocks, order, block_number, data) ? 1 : -2;
 }
 
 int NFCFramework::felica_read_without_encryption(uint8_t service_codes_list_length, uint16_t *service_codes, uint8_t block_number, uint16_t *block_list, uint8_t data[][16])
@@ -438,8 +1491,8 @@ int NFCFramework::felica_read_without_encryption(uint8_t service_codes_list_leng
     uint8_t _idm[8];
     uint8_t _pmm[8];
     uint16_t sys_code;
-    if(felica_polling(_idm, _pmm, &sys_code)) { // Wait for a FeliCa card
-        int result = nfc->felica_ReadWithoutEncryption(service_codes_list_length, service_codes, block_number, block_list, data);
+    if(felica_polling(_idm, _pmm, &sys_code) == 1) { // Wait for a FeliCa card
+        int result = felica_transfer(FELICA_CMD_READ_WITHOUT_ENCRYPTION, service_codes_list_length, service_codes, block_number, block_list, data);
         if (result <= 0)
         {
             data = NULL;
@@ -459,25 +1512,56 @@ int NFCFramework::felica_write_without_encryption(uint8_t service_codes_list_len
     uint8_t _idm[8];
     uint8_t _pmm[8];
     uint16_t sys_code;
-    if(felica_polling(_idm, _pmm, &sys_code)) { // Wait for a FeliCa card
-        return nfc->felica_WriteWithoutEncryption(service_codes_list_length, service_codes, block_number, block_list, data);
+    if(felica_polling(_idm, _pmm, &sys_code) == 1) { // Wait for a FeliCa card
+        return felica_transfer(FELICA_CMD_WRITE_WITHOUT_ENCRYPTION, service_codes_list_length, service_codes, block_number, block_list, data);
     } else {
         return -1;
     }
 }
 
+void NFCFramework::felica_release()
+{
+    uint8_t cmd[] = {PN532_COMMAND_INRELEASE, 0x00};  // All targets
+    uint8_t status;
+    if (ensure_awake())
+        transport->command(cmd, sizeof(cmd), &status, 1);
+}
+
+bool NFCFramework::iso_dep_select(IsoDepInfo *info, uint8_t max_rate)
+{
+    if (!ensure_awake())
+        return false;
+    if (iso_dep == NULL)
+        iso_dep = new IsoDep(transport);
+    return iso_dep->select(info, max_rate);
+}
+
+int32_t NFCFramework::apdu_exchange(const uint8_t *apdu, size_t apdu_len, uint8_t *response, size_t response_max)
+{
+    if (!ensure_awake())
+        return -1;
+    if (iso_dep == NULL)
+        iso_dep = new IsoDep(transport);
+    return iso_dep->transceive(apdu, apdu_len, response, response_max);
+}
+
+bool NFCFramework::emv_transceive(const uint8_t *apdu, size_t apdu_len, std::vector<uint8_t> *response)
+{
+    response->resize(EMV_RESPONSE_MAX);
+    int32_t len = apdu_exchange(apdu, apdu_len, response->data(), response->size());
+    response->resize(len < 0 ? 0 : len);
+    return len >= 0;
+}
+
 std::vector<uint8_t> NFCFramework::emv_ask_for_aid() {
-    uint8_t uid[7];
-    uint8_t len;
-    uint8_t response[240];
-    uint8_t response_len = 0;
+    std::vector<uint8_t> response_vector;
     std::vector<uint8_t> aid;
-    if(get_tag_uid(uid, &len)) {
+    IsoDepInfo info;
+    if(iso_dep_select(&info)) {
 
         /* Select Application */
         uint8_t ask_for_aid_apdu[] ={0x00, 0xA4, 0x04, 0x00, 0x0e, 0x32, 0x50, 0x41, 0x59, 0x2e, 0x53, 0x59, 0x53, 0x2e, 0x44, 0x44, 0x46, 0x30, 0x31, 0x00};
-        if(nfc->EMVinDataExchange(ask_for_aid_apdu, sizeof(ask_for_aid_apdu), response, &response_len)) {
-            std::vector<uint8_t> response_vector(&response[0], &response[response_len]);
+        if(emv_transceive(ask_for_aid_apdu, sizeof(ask_for_aid_apdu), &response_vector)) {
             BerTlv Tlv;
             Tlv.SetTlv(response_vector);
             if(Tlv.GetValue("4F", &aid) != OK) {  // Application ID
@@ -491,14 +1575,10 @@ std::vector<uint8_t> NFCFramework::emv_ask_for_aid() {
 }
 
 std::vector<uint8_t> NFCFramework::emv_ask_for_app_name() {
-    uint8_t uid[7];
-    uint8_t len;
-    uint8_t response[240];
-    uint8_t response_len = 0;
+    std::vector<uint8_t> response_vector;
     std::vector<uint8_t> app_name;
     uint8_t ask_for_aid_apdu[] ={0x00, 0xA4, 0x04, 0x00, 0x0e, 0x32, 0x50, 0x41, 0x59, 0x2e, 0x53, 0x59, 0x53, 0x2e, 0x44, 0x44, 0x46, 0x30, 0x31, 0x00};
-    if(nfc->EMVinDataExchange(ask_for_aid_apdu, sizeof(ask_for_aid_apdu), response, &response_len)) {
-        std::vector<uint8_t> response_vector(&response[0], &response[response_len]);
+    if(emv_transceive(ask_for_aid_apdu, sizeof(ask_for_aid_apdu), &response_vector)) {
         BerTlv Tlv;
         Tlv.SetTlv(response_vector);
         if(Tlv.GetValue("50", &app_name) != OK) {  // Card name
@@ -511,17 +1591,13 @@ std::vector<uint8_t> NFCFramework::emv_ask_for_app_name() {
 }
 
 std::vector<uint8_t> NFCFramework::emv_ask_for_pdol(std::vector<uint8_t> *aid) {
-    uint8_t uid[7];
-    uint8_t len;
-    uint8_t response[240];
-    uint8_t response_len = 0;
+    std::vector<uint8_t> response_vector;
     std::vector<uint8_t> pdol;
                                                               /* ------------------- AID -----------------*/
     uint8_t ask_for_pdol[] = {0x00 , 0xa4, 0x04, 0x00, 0x07,  0x00 ,0x00 , 0x00 , 0x00 , 0x00 , 0x00, 0x90, 0x00};
     memcpy(ask_for_pdol+5, aid->data(), 7);
 
-    if(nfc->EMVinDataExchange(ask_for_pdol, sizeof(ask_for_pdol), response, &response_len)) {
-        std::vector<uint8_t> response_vector(&response[0], &response[response_len]);
+    if(emv_transceive(ask_for_pdol, sizeof(ask_for_pdol), &response_vector)) {
         BerTlv Tlv;
         Tlv.SetTlv(response_vector);
         if(Tlv.GetValue("9F38", &pdol) != OK) {  // PDOL(Some card doesn't have it)
@@ -533,15 +1609,11 @@ std::vector<uint8_t> NFCFramework::emv_ask_for_pdol(std::vector<uint8_t> *aid) {
 }
 
 std::vector<uint8_t> NFCFramework::emv_ask_for_afl() {
-    uint8_t uid[7];
-    uint8_t len;
-    uint8_t response[240];
-    uint8_t response_len = 0;
+    std::vector<uint8_t> response_vector;
     std::vector<uint8_t> afl;
     uint8_t ask_for_afl[] = {0x80, 0xa8, 0x00, 0x00, 0x02, 0x83, 0x00, 0x00};   // Get AFL
 
-    if(nfc->EMVinDataExchange(ask_for_afl, sizeof(ask_for_afl), response, &response_len)) {
-        std::vector<uint8_t> response_vector(&response[0], &response[response_len]);
+    if(emv_transceive(ask_for_afl, sizeof(ask_for_afl), &response_vector)) {
         BerTlv Tlv;
         Tlv.SetTlv(response_vector);
         if(Tlv.GetValue("94", &afl) != OK) {  // AFL
@@ -553,17 +1625,11 @@ std::vector<uint8_t> NFCFramework::emv_ask_for_afl() {
 }
 
 std::vector<uint8_t> NFCFramework::emv_read_afl(uint8_t p2) {
-    uint8_t uid[7];
-    uint8_t len;
-    uint8_t response[240];
-    uint8_t response_len = 0;
     std::vector<uint8_t> result;
 
     uint8_t read_afl[] = { 0x00, 0xB2, 0x01, 0x00, 0x00 };
     read_afl[3] = p2;
         
-    if(nfc->EMVinDataExchange(read_afl, sizeof(read_afl), response, &response_len)) {
-        result = std::vector<uint8_t>(&response[0], &response[response_len]);
-    }
+    emv_transceive(read_afl, sizeof(read_afl), &result);
     return result;
 }
\ No newline at end of file
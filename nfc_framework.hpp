@@ -23,6 +23,13 @@
 #include "Adafruit_PN532.h"
 #include <SPI.h>
 #include <vector>
+#include "pn532_transport.hpp"
+#include "ndef.hpp"
+#include "dump_planner.hpp"
+#include "mifare_access.hpp"
+#include "mifare_value.hpp"
+#include "iso_dep.hpp"
+#include "nfc_trace.hpp"
 
 // Some Mifare definitions
 #define MIFARE_CLASSIC_SIZE 1024
@@ -44,6 +51,22 @@
 // FeliCa definitions
 #define DEFAULT_SYSTEM_CODE 0xFFFF
 #define DEFAULT_REQUEST_CODE 0x01
+#define FELICA_POLLING_TIMEOUT 65535    // ms felica_polling waits for a card
+#ifndef FELICA_CMD_POLLING
+#define FELICA_CMD_POLLING 0x00
+#define FELICA_CMD_READ_WITHOUT_ENCRYPTION 0x06
+#define FELICA_CMD_WRITE_WITHOUT_ENCRYPTION 0x08
+#endif
+#define FELICA_LITE_SERVICE_RW 0x0009   // S_PAD0-13 of FeliCa Lite/Lite-S
+#define FELICA_IC_LITE 0xF0             // PMm IC type
+#define FELICA_IC_LITE_S 0xF1
+#define FELICA_LITE_MAX_READ 4
+#define FELICA_LITE_MAX_WRITE 1
+#define FELICA_MAX_BLOCKS_PER_WRITE 8   // Standard FeliCa ICs
+#define FELICA_MAX_SERVICES 16          // Services in one command
+#define FELICA_FRAME_MAX 252            // FeliCa frame carried by a single InDataExchange
+#define FELICA_PMM_READ_TIME 5          // PMm bytes with read/write response time parameters
+#define FELICA_PMM_WRITE_TIME 6
 
 // Manufacturer codes for FeliCa cards as per Sony documentation
 enum FelicaManufacturer {
@@ -65,9 +88,12 @@ enum FelicaSystemCodes {
     PLUG = 0xFEE1
 };
 
+// ISO-DEP/EMV definitions
+#define EMV_RESPONSE_MAX 1024           // Records chained through 61xx can be longer than a short APDU
+
 typedef struct DumpResult{
-    uint8_t unreadable = 0;
-    uint8_t unauthenticated = 0;
+    uint16_t unreadable = 0;
+    uint16_t unauthenticated = 0;
 } DumpResult;
 
 typedef enum KeyType {
@@ -79,6 +105,34 @@ typedef struct Key {
     KeyType type;
     uint8_t data[6];
 } Key;
+
+// Both keys of a sector, the framework picks the one access bits allow
+typedef struct SectorKeys {
+    bool has_key_a = false;
+    uint8_t key_a[6] = {0};
+    bool has_key_b = false;
+    uint8_t key_b[6] = {0};
+} SectorKeys;
+// What the current card told about the keys of a sector, ACCESS_KEY_* masks
+typedef struct SectorAuthState {
+    bool access_tried = false;  // Trailer already read or found unreadable
+    uint8_t proven = 0;         // Keys the card accepted
+    uint8_t refused = 0;        // Keys the card refused, not sent again
+} SectorAuthState;
+// FeliCa block to write, addressed by its service
+typedef struct FelicaBlock {
+    uint16_t service = FELICA_LITE_SERVICE_RW;
+    uint16_t block = 0;
+    uint8_t data[16] = {0};
+} FelicaBlock;
+
+typedef struct FelicaWriteResult {
+    uint16_t changed = 0;   // Blocks different from the card(or unreadable)
+    uint16_t written = 0;
+    uint16_t verified = 0;  // Written blocks read back with the expected content
+    uint16_t frames = 0;    // Write Without Encryption commands sent
+} FelicaWriteResult;
+
 typedef struct TagType {
     const char *name;
     uint16_t atqa;
@@ -91,6 +145,58 @@ typedef struct TagType {
 // #define MIFARE_CLASSIC_4K (TagType){0x04, 0x03, 16, 264 }
 #define MIFARE_MINI (TagType){"Mifare Mini",0x04, 0x09, 4, 20}
 
+// InAutoPoll target types
+#define AUTOPOLL_GENERIC_106 0x00
+#define AUTOPOLL_GENERIC_FELICA_212 0x01
+#define AUTOPOLL_GENERIC_FELICA_424 0x02
+#define AUTOPOLL_GENERIC_TYPE_B 0x03
+#define AUTOPOLL_JEWEL 0x04
+#define AUTOPOLL_MIFARE 0x10
+#define AUTOPOLL_FELICA_212 0x11
+#define AUTOPOLL_FELICA_424 0x12
+#define AUTOPOLL_ISO14443_4A 0x20
+#define AUTOPOLL_ISO14443_4B 0x23
+#define AUTOPOLL_PERIOD_UNIT 150    // ms
+#define AUTOPOLL_MAX_TYPES 4
+
+// PowerDown wake up sources
+#define WAKEUP_INT0 0x01
+#define WAKEUP_INT1 0x02
+#define WAKEUP_RF 0x08
+#define WAKEUP_HSU 0x10
+#define WAKEUP_SPI 0x20
+#define WAKEUP_I2C 0x80
+#define WAKEUP_HOST (WAKEUP_HSU | WAKEUP_SPI | WAKEUP_I2C)
+
+typedef struct PresenceConfig {
+    uint16_t period = AUTOPOLL_PERIOD_UNIT; // ms between two polls, rounded to 150ms steps(max 2250ms)
+    uint8_t polls = 1;                      // Polls per presence_poll call, max 254
+    uint8_t types[AUTOPOLL_MAX_TYPES] = {AUTOPOLL_MIFARE};
+    uint8_t types_count = 1;
+    /*
+        Put PN532 in PowerDown when no card is around, presence_poll sleeps
+        on the IRQ line for the poll window and polls again after it.
+        Ignored without an IRQ line. The RF wake up source only fires on an
+        external field(a phone or a reader), a passive card is found by the
+        next poll
+    */
+    bool power_down = false;
+} PresenceConfig;
+
+typedef enum PresenceEventType {
+    PRESENCE_NONE,
+    PRESENCE_ARRIVED,
+    PRESENCE_REMOVED
+} PresenceEventType;
+
+typedef struct PresenceEvent {
+    PresenceEventType type = PRESENCE_NONE;
+    uint8_t card_type = 0;  // AUTOPOLL_* type that found the card
+    uint8_t uid[8] = {0};   // NFCID1, FeliCa IDm, Type B PUPI or Jewel ID
+    uint8_t uid_length = 0;
+    unsigned long timestamp = 0;
+} PresenceEvent;
+
 // Debug macros
 #ifdef ESP32S3_DEVKITC_BOARD
 #define SERIAL_DEVICE Serial0
@@ -102,46 +208,159 @@ typedef struct TagType {
 #define LOG_SUCCESS(reason) SERIAL_DEVICE.printf("\e[32m%s\e[0m", reason)
 #define LOG_INFO(reason) SERIAL_DEVICE.printf("%s", reason)
 
+class NFCTag;
+
 class NFCFramework
 {
 private:
     Adafruit_PN532 *nfc;
+    PN532Transport *transport;
     void print_block(int currentblock, uint8_t *block);
     void print_error(int block_number, const char *reason);
     uint8_t *prepare_tag_store(uint8_t *tag_data, size_t tag_size); 
+    // Move a dump plan image to the layout of the first dump_tag versions(16 bytes per page, at least 1024/512 bytes)
+    uint8_t *legacy_image(DumpPlan *plan, uint8_t *image);
 
     // Create JIS system code(0xAA00 to 0xAAFE) dynamically to save some memory
     void fill_JIS_system_code(uint8_t *out);
+
+    // Send data to the selected target and put its answer(without PN532 status) in response
+    bool in_data_exchange(uint8_t *data, uint8_t data_len, uint8_t *response, uint8_t *response_len, uint16_t timeout = PN532_DEFAULT_TIMEOUT);
+    bool mifareclassic_read(uint8_t block, uint8_t *out);
+    bool mifareclassic_write(uint8_t block, uint8_t *data);
+    bool mifareclassic_auth(DumpPlan *plan, uint8_t block, KeyType key_type, uint8_t *key);
+    // Select an ISO14443A card through the transport
+    bool select_tag(uint8_t *uid, uint8_t *uid_length, uint16_t *atqa, uint8_t *sak);
+    // Select again the card in the field, needed after a failed authentication or read
+    bool reselect_tag();
+
+    // Access conditions of the last Classic card, learnt from its sector trailers
+    SectorAccess access_cache[MIFARE_CLASSIC_MAX_SECTORS];
+    uint8_t access_uid[7] = {0};
+    // Reset on every plan, keys given to the next call may differ
+    SectorAuthState auth_state[MIFARE_CLASSIC_MAX_SECTORS];
+    int16_t auth_sector = -1;   // Sector authenticated in the current selection, -1 if none
+    KeyType auth_key = KEY_A;
+    bool authenticate_sector(DumpPlan *plan, uint8_t sector, KeyType key_type, SectorKeys *keys);
+    // Read sector trailer into trailer, return -1 if no key works, 0 if it's unreadable, 1 if access bits are known
+    int learn_access(DumpPlan *plan, uint8_t sector, SectorKeys *keys, uint8_t *trailer);
+    // ACCESS_KEY_* mask of the given keys allowed to run op on block
+    uint8_t access_keys(DumpPlan *plan, uint16_t block, AccessOperation op, SectorKeys *keys);
+    // Authenticate sector with one of the allowed keys, keeping the current authentication if possible
+    bool authenticate_keys(DumpPlan *plan, uint8_t sector, uint8_t allowed, SectorKeys *keys);
+    /*
+        Authenticate block sector with a key allowed to run op on it.
+        Return false without talking to the card when access conditions deny op
+    */
+    bool authenticate_for(DumpPlan *plan, uint16_t block, AccessOperation op, SectorKeys *keys);
+    // Drop cached access bits and key results of the sector when block is its trailer, after writing it
+    void forget_trailer(size_t block_number);
+    ValueStatus run_value_operation(DumpPlan *plan, ValueOperation *operation, SectorKeys *keys);
+    // Type 2 tag READ returns four pages(16 bytes) at once
+    bool ntag_read_pages(uint8_t page, uint8_t *out);
+    bool ntag_write_page(uint8_t page, uint8_t *data);
+    // Read the byte at offset from the start of the tag, window holds the last four pages read from window_page
+    bool ntag_read_byte(size_t offset, uint8_t *out, uint8_t *window, int *window_page);
+
+    // Poll a FeliCa card through the transport
+    bool felica_select(uint16_t system_code, uint8_t *idm, uint8_t *pmm);
+    // Card found by the last felica_polling
+    uint8_t felica_idm[8] = {0};
+    uint8_t felica_pmm[8] = {0};
+    // Read/Write Without Encryption with two bytes block list elements on the last polled card, 1 on success
+    int felica_transfer(uint8_t command, uint8_t service_codes_list_length, uint16_t *service_codes, uint8_t block_number, uint16_t *block_list, uint8_t data[][16]);
+    // Blocks from blocks[order[0]] that fit in one command frame with at most max_blocks blocks
+    uint8_t felica_pack(FelicaBlock *blocks, uint16_t *order, size_t count, uint8_t max_blocks, bool with_data);
+    // Read or write blocks[order[0..n-1]] in a single command, read data goes in out
+    bool felica_exchange(uint8_t command, uint8_t *idm, uint8_t *pmm, FelicaBlock *blocks, uint16_t *order, uint8_t n, uint8_t out[][16]);
+    // felica_write_blocks on the card felica_select already found
+    bool felica_write_blocks(uint8_t *idm, uint8_t *pmm, FelicaBlock *blocks, size_t count, FelicaWriteResult *result);
+
+    PresenceConfig presence_config;
+    PresenceEvent present_card;     // Card in the field, type is PRESENCE_NONE if there isn't one
+    PresenceEvent pending_card;     // New card found while reporting the previous one removal
+    bool sleeping = false;
+    // Leave LowVbat mode so PN532 can talk to cards, like Adafruit_PN532::SAMConfig on the transport
+    bool sam_config();
+    // Wake up PN532 if it's in PowerDown, every function talking to it goes through this
+    bool ensure_awake();
+
+    IsoDep *iso_dep = NULL;     // Created on first use
+    // APDU exchange into a vector holding the whole answer(status word included)
+    bool emv_transceive(const uint8_t *apdu, size_t apdu_len, std::vector<uint8_t> *response);
 public:
     // NFCFramework(int sck, int miso, int mosi, int ss);
     NFCFramework(uint8_t sck, uint8_t miso, uint8_t mosi, uint8_t ss){
         nfc = new Adafruit_PN532(sck, miso, mosi, ss);
+        transport = new PN532SPI(sck, miso, mosi, ss);
+        LOG_INFO("Init NFC Framework");
+        nfc->begin();
+        transport->begin();
+        nfc->SAMConfig();
+    }
+    // Hardware SPI, clock can go up to PN532_SPI_MAX_CLOCK
+    NFCFramework(uint8_t ss, SPIClass *spi, uint32_t clock = PN532_SPI_MAX_CLOCK){
+        nfc = new Adafruit_PN532(ss, spi);
+        transport = new PN532SPI(ss, spi, clock);
         LOG_INFO("Init NFC Framework");
         nfc->begin();
+        transport->begin();
         nfc->SAMConfig();
     }
     NFCFramework(uint8_t irq, uint8_t rst){
         nfc = new Adafruit_PN532(irq, rst);
+        transport = new PN532I2C(&Wire, irq);
         LOG_INFO("Init NFC Framework");
         nfc->begin();
+        transport->begin();
         nfc->SAMConfig();
     }
-    ~NFCFramework();
-    bool ready();
-    void power_down() {
-        nfc->reset();
+    // I2C on a custom bus, use PN532_I2C_FAST_CLOCK for fast mode
+    NFCFramework(uint8_t irq, uint8_t rst, TwoWire *wire, uint32_t clock = PN532_I2C_FAST_CLOCK){
+        nfc = new Adafruit_PN532(irq, rst, wire);
+        transport = new PN532I2C(wire, irq, clock);
+        LOG_INFO("Init NFC Framework");
         nfc->begin();
+        transport->begin();
         nfc->SAMConfig();
     }
-    uint32_t get_version() {
-        return nfc->getFirmwareVersion();
+    /*
+        Framework on a custom transport(e.g. PN532Replay), it takes ownership of it.
+        Every function but emulate_tag is available, card emulation still needs Adafruit_PN532
+    */
+    NFCFramework(PN532Transport *_transport){
+        nfc = NULL;
+        transport = _transport;
+        LOG_INFO("Init NFC Framework");
+        transport->begin();
+        sam_config();
+    }
+    ~NFCFramework();
+    bool ready();
+    // Put PN532 in PowerDown, it can be woken up by host interface and by the given sources. Nothing is sent if it's already sleeping
+    bool power_down(uint8_t wakeup_sources = 0);
+    bool wake_up();
+    // IC, version, revision and supported cards as returned by GetFirmwareVersion, 0 on error
+    uint32_t get_version();
+    /*
+        Send a raw PN532 command through the framework transport.
+        Return the response length(without response code) or a negative value on error
+    */
+    int16_t pn532_command(const uint8_t *cmd, uint8_t cmd_len, uint8_t *response, uint8_t response_len, uint16_t timeout = PN532_DEFAULT_TIMEOUT) {
+        if (!ensure_awake())
+            return -1;
+        return transport->command(cmd, cmd_len, response, response_len, timeout);
     }
+    // Record PN532 commands and responses in trace, NULL to stop
+    void set_trace(NFCTrace *trace) { transport->set_trace(trace); };
+    // Share lock with the other PN532 modules on the same bus
+    void set_bus_lock(std::mutex *lock) { transport->set_bus_lock(lock); };
     void printHex(byte *data, uint32_t length) {
     for (uint8_t i = 0; i < length; i++) {
         if (data[i] < 0x10) {
             LOG_INFO(" 0");
         } else {
-            LOG_INFO(' ');
+            LOG_INFO(" ");
         }
         SERIAL_DEVICE.print(data[i], HEX);
     }
@@ -160,38 +379,106 @@ public:
     int get_tag_uid(uint8_t *uid, uint8_t *length);
     int get_tag_uid(uint8_t *uid, uint8_t *length, uint16_t *atqa, uint8_t *sak);
 
+    /*
+        Card presence detection through PN532 InAutoPoll.
+        presence_poll blocks for at most config polls and reports card arrival or removal
+    */
+    void presence_begin(PresenceConfig config);
+    bool presence_poll(PresenceEvent *event);
+
     // Mifare functions
     bool auth_tag(uint8_t *key, uint8_t block_number, KeyType key_type);
     bool write_tag(size_t block_number, uint8_t *data, uint8_t key_type, uint8_t *key);
     
     bool read_block(uint8_t block, uint8_t *key, KeyType key_type, uint8_t *out);
-    // uint8_t *dump_tag(uint8_t key[], size_t *uid_length);
+    // Read/write choosing the key type from sector access bits
+    bool read_block(uint8_t block, SectorKeys *keys, uint8_t *out);
+    bool write_tag(size_t block_number, uint8_t *data, SectorKeys *keys);
+    /*
+        Run operations in order on value blocks within a single card selection,
+        each sector is authenticated once while the key allows the following operations.
+        keys holds both keys per sector. Status of each operation is set in it.
+        Return the number of successful operations or -1 if no Classic card is found
+    */
+    int value_batch(ValueOperation *operations, size_t count, SectorKeys *keys);
+    /*
+        Dump the card in the field as planned by plan_dump, in the old layout read by
+        NFCTag(data, uid_length): Ultralight/NTAG pages take 16 bytes each. key is
+        the Key A of every sector, keys has one key every four blocks up to blocks
+    */
     uint8_t* dump_tag(uint8_t key[], size_t *uid_length, DumpResult *result);
     uint8_t* dump_tag(Key *key, uint8_t blocks, DumpResult *result);
+    // Identify the card in the field and build its exact read plan
+    bool plan_dump(DumpPlan *plan);
+    /*
+        Dump the card selected by plan_dump reading only what the plan
+        contains. keys holds one key per sector(Classic only).
+        Return a buffer of dump_plan_image_size(plan) bytes
+    */
+    uint8_t* dump_tag(DumpPlan *plan, Key *keys, DumpResult *result);
+    // Same but keys holds both keys per sector, blocks denied by access bits are skipped
+    uint8_t* dump_tag(DumpPlan *plan, SectorKeys *keys, DumpResult *result);
 
     // NFCTAG21xx functions
     uint8_t *dump_ntag2xx_tag(size_t pages);
     bool write_ntag2xx_page(size_t page, uint8_t *data);
+
+    /*
+        NDEF functions
+        Read only the pages/blocks holding the NDEF message and put it in message,
+        use NDEFParser on it to get the records.
+        Return the message length or -1 on error
+    */
+    int ndef_read(uint8_t *message, size_t max_len);
+    // Write the records as NDEF message TLV after the Lock/Memory Control TLVs, touching only the pages it covers
+    bool ndef_write(NDEFRecord *records, size_t count);
+    int felica_ndef_read(uint8_t *message, size_t max_len);
     
     // FeliCa functions
     int felica_polling(uint8_t *idm, uint8_t *pmm, uint16_t *response_code);
-    int felica_polling(uint8_t system_code, uint8_t *idm, uint8_t *pmm, uint16_t *response_code);
-    int felica_polling(uint8_t system_code, uint8_t request_code ,uint8_t *idm, uint8_t *pmm, uint16_t *response_code);
+    int felica_polling(uint16_t system_code, uint8_t *idm, uint8_t *pmm, uint16_t *response_code);
+    int felica_polling(uint16_t system_code, uint8_t request_code ,uint8_t *idm, uint8_t *pmm, uint16_t *response_code);
     int felica_read_without_encryption(uint8_t service_codes_list_length, uint16_t *service_codes, uint8_t block_number, uint16_t *block_list, uint8_t data[][16]);
     int felica_write_without_encryption(uint8_t service_codes_list_length, uint16_t *service_codes, uint8_t block_number, uint16_t *block_list, uint8_t data[][16]);
-    void felica_release() { nfc->felica_Release(); };
+    void felica_release();
+    /*
+        Poll once, read the current content of blocks and write only the
+        different ones, packing them into as few Write Without Encryption
+        commands as the card allows, then read back the written blocks.
+        Return true when every changed block is verified
+    */
+    bool felica_write_blocks(FelicaBlock *blocks, size_t count, FelicaWriteResult *result);
+    /*
+        Restore the 14 blocks FeliCa image held by tag. Without services both
+        image and card must be Lite/Lite-S(S_PAD0-13), other cards need the
+        service code of each block
+    */
+    bool felica_restore(NFCTag *tag, FelicaWriteResult *result, const uint16_t *services = NULL);
 
+    // Card emulation goes through Adafruit_PN532, so it isn't traced and fails on custom transports
     bool emulate_tag(uint8_t *uid) {
+        if (nfc == NULL || !ensure_awake())
+            return false;
         uint8_t empty[10];
         memset(empty, 0, 10);
         return nfc->AsTarget(uid, empty, empty, empty); 
     }; 
     bool emulate_tag(uint8_t *idm, uint8_t *pmm, uint8_t *sys_code) {
+        if (nfc == NULL || !ensure_awake())
+            return false;
         uint8_t empty[10];
         memset(empty, 0, 10);
         return nfc->AsTarget(empty, idm, pmm, sys_code); 
     };
 
+    /*
+        ISO 14443-4 cards(EMV, DESFire, ...): activate the card at the fastest
+        bit rate both sides support, then exchange APDUs of any length.
+        apdu_exchange returns the answer length(status word included) or -1
+    */
+    bool iso_dep_select(IsoDepInfo *info, uint8_t max_rate = ISO_DEP_424);
+    int32_t apdu_exchange(const uint8_t *apdu, size_t apdu_len, uint8_t *response, size_t response_max);
+
     // EMV methods created with the help of https://werner.rothschopf.net/201703_arduino_esp8266_nfc.htm
     std::vector<uint8_t> emv_ask_for_aid();
     std::vector<uint8_t> emv_ask_for_app_name();
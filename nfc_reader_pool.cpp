@@ -0,0 +1,201 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "nfc_reader_pool.hpp"
+#include <stdexcept>
+
+NFCReaderPool::~NFCReaderPool()
+{
+    stop();
+}
+
+size_t NFCReaderPool::add_reader(NFCFramework *reader, std::mutex *bus)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if (running)
+    {
+        LOG_ERROR("Can't add a reader to a running pool\n");
+        return readers.size();
+    }
+    reader->set_bus_lock(bus);
+    readers.push_back(reader);
+    completed.push_back(0);
+    return readers.size() - 1;
+}
+
+void NFCReaderPool::start()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if (running)
+        return;
+    running = true;
+    for (size_t i = 0; i < readers.size(); i++)
+    {
+        workers.push_back(std::thread(&NFCReaderPool::worker, this, i));
+    }
+}
+
+void NFCReaderPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!running)
+            return;
+        running = false;
+    }
+    job_available.notify_all();
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+    workers.clear();
+}
+
+void NFCReaderPool::worker(size_t reader)
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            // Keep serving the queue after stop() so no submitted future is left pending
+            job_available.wait(guard, [this] { return !running || !jobs.empty(); });
+            if (jobs.empty())
+                return;
+            job = jobs.front();
+            jobs.pop_front();
+            busy++;
+        }
+
+        job(readers[reader], reader);
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            busy--;
+            completed[reader]++;
+        }
+        job_done.notify_all();
+    }
+}
+
+void NFCReaderPool::enqueue(Job job)
+{
+    bool queued;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        queued = running && !readers.empty();
+        if (queued)
+            jobs.push_back(job);
+    }
+    if (queued)
+        job_available.notify_one();
+    else
+        job(NULL, 0);
+}
+
+/* Fail the future of a job nobody will serve, true if nfc is NULL */
+template <typename T>
+static bool reject_job(const std::shared_ptr<std::promise<T>> &promise, NFCFramework *nfc)
+{
+    if (nfc != NULL)
+        return false;
+    promise->set_exception(std::make_exception_ptr(std::runtime_error("Reader pool isn't running or has no readers")));
+    return true;
+}
+
+std::future<ScanResult> NFCReaderPool::submit_scan()
+{
+    std::shared_ptr<std::promise<ScanResult>> promise = std::make_shared<std::promise<ScanResult>>();
+    enqueue([promise](NFCFramework *nfc, size_t reader) {
+        if (reject_job(promise, nfc))
+            return;
+        ScanResult result;
+        result.reader = reader;
+        result.found = nfc->get_tag_uid(result.uid, &result.uid_length);
+        promise->set_value(result);
+    });
+    return promise->get_future();
+}
+
+std::future<PoolDumpResult> NFCReaderPool::submit_dump(uint8_t key[])
+{
+    std::shared_ptr<std::promise<PoolDumpResult>> promise = std::make_shared<std::promise<PoolDumpResult>>();
+    std::vector<uint8_t> job_key(key, key + 6);
+    enqueue([promise, job_key](NFCFramework *nfc, size_t reader) mutable {
+        if (reject_job(promise, nfc))
+            return;
+        PoolDumpResult result;
+        size_t uid_length = 0;
+        result.reader = reader;
+        result.data = nfc->dump_tag(job_key.data(), &uid_length, &result.result);
+        promise->set_value(result);
+    });
+    return promise->get_future();
+}
+
+std::future<PoolDumpResult> NFCReaderPool::submit_dump(Key *keys, uint8_t blocks)
+{
+    std::shared_ptr<std::promise<PoolDumpResult>> promise = std::make_shared<std::promise<PoolDumpResult>>();
+    // One key per sector, copied since the caller buffer may be gone when the job runs
+    std::vector<Key> job_keys(keys, keys + (blocks + 3) / 4);
+    enqueue([promise, job_keys, blocks](NFCFramework *nfc, size_t reader) mutable {
+        if (reject_job(promise, nfc))
+            return;
+        PoolDumpResult result;
+        result.reader = reader;
+        result.data = nfc->dump_tag(job_keys.data(), blocks, &result.result);
+        promise->set_value(result);
+    });
+    return promise->get_future();
+}
+
+std::future<bool> NFCReaderPool::submit_write(size_t block_number, uint8_t *data, uint8_t key_type, uint8_t *key)
+{
+    std::shared_ptr<std::promise<bool>> promise = std::make_shared<std::promise<bool>>();
+    std::vector<uint8_t> job_data(data, data + BLOCK_SIZE);
+    std::vector<uint8_t> job_key(key, key + 6);
+    enqueue([promise, block_number, job_data, key_type, job_key](NFCFramework *nfc, size_t reader) mutable {
+        if (reject_job(promise, nfc))
+            return;
+        promise->set_value(nfc->write_tag(block_number, job_data.data(), key_type, job_key.data()));
+    });
+    return promise->get_future();
+}
+
+void NFCReaderPool::wait_all()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    job_done.wait(guard, [this] { return jobs.empty() && busy == 0; });
+}
+
+PoolStats NFCReaderPool::get_stats()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    PoolStats stats;
+    stats.busy = busy;
+    for (size_t i = 0; i < completed.size(); i++)
+    {
+        stats.jobs_done += completed[i];
+    }
+    return stats;
+}
+
+size_t NFCReaderPool::get_completed(size_t reader)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return reader < completed.size() ? completed[reader] : 0;
+}
@@ -0,0 +1,97 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NFC_READER_POOL_H
+#define NFC_READER_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "nfc_framework.hpp"
+
+typedef struct ScanResult {
+    bool found = false;
+    uint8_t uid[7] = {0};
+    uint8_t uid_length = 0;
+    size_t reader = 0;     // Index of the reader that served the job
+} ScanResult;
+
+typedef struct PoolDumpResult {
+    uint8_t *data = NULL;  // malloc'd by the reader, free it or hand it to NFCTag
+    DumpResult result;
+    size_t reader = 0;
+} PoolDumpResult;
+
+typedef struct PoolStats {
+    size_t jobs_done = 0;
+    size_t busy = 0;       // Readers currently running a job
+} PoolStats;
+
+/*
+    Run scan, dump and write jobs across several PN532 modules.
+    Every reader gets its own worker thread, so while one PN532 is
+    waiting for the card the others keep working. Readers sharing a
+    bus(SPI chip selects or I2C addresses on the same bus) are added
+    with the same bus mutex, held for each bus transaction only.
+    A reader must not be used outside the pool while the pool is running.
+    Jobs submitted while the pool isn't running, or has no readers,
+    fail with a std::runtime_error in their future.
+*/
+class NFCReaderPool
+{
+private:
+    typedef std::function<void(NFCFramework *, size_t)> Job;
+
+    std::vector<NFCFramework *> readers;
+    std::vector<std::thread> workers;
+    std::vector<size_t> completed;
+    std::deque<Job> jobs;
+    std::mutex lock;
+    std::condition_variable job_available;
+    std::condition_variable job_done;
+    size_t busy = 0;
+    bool running = false;
+
+    void worker(size_t reader);
+    // Queue job, or run it at once with a NULL reader when nothing would serve it
+    void enqueue(Job job);
+public:
+    NFCReaderPool() {};
+    ~NFCReaderPool();
+    // Readers must be added before start(), bus is shared by the readers on the same bus(NULL if alone)
+    size_t add_reader(NFCFramework *reader, std::mutex *bus = NULL);
+    inline size_t size() { return readers.size(); };
+    void start();
+    // Wait for queued jobs to complete and join all the workers
+    void stop();
+
+    std::future<ScanResult> submit_scan();
+    std::future<PoolDumpResult> submit_dump(uint8_t key[]);
+    std::future<PoolDumpResult> submit_dump(Key *keys, uint8_t blocks);
+    std::future<bool> submit_write(size_t block_number, uint8_t *data, uint8_t key_type, uint8_t *key);
+
+    // Block until every submitted job has been served
+    void wait_all();
+    PoolStats get_stats();
+    size_t get_completed(size_t reader);
+};
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "nfc_trace.hpp"
+#include "nfc_framework.hpp"
+
+NFCTrace::NFCTrace(size_t _size) : size(_size), head(0), tail(0), dropped(0)
+{
+    buffer = (uint8_t *)malloc(size);
+}
+
+NFCTrace::~NFCTrace()
+{
+    free(buffer);
+}
+
+void NFCTrace::record(uint8_t direction, const uint8_t *data, uint8_t len)
+{
+    if (buffer == NULL)
+        return;
+    if (size - used() < (size_t)TRACE_RECORD_HEADER_SIZE + len)
+    {
+        dropped++;
+        return;
+    }
+
+    uint32_t timestamp = micros();
+    uint8_t header[TRACE_RECORD_HEADER_SIZE] = {direction, len, (uint8_t)timestamp, (uint8_t)(timestamp >> 8),
+                                                (uint8_t)(timestamp >> 16), (uint8_t)(timestamp >> 24)};
+    size_t position = head.load(std::memory_order_relaxed);
+    for (uint8_t i = 0; i < TRACE_RECORD_HEADER_SIZE; i++)
+    {
+        buffer[position++ % size] = header[i];
+    }
+    for (uint8_t i = 0; i < len; i++)
+    {
+        buffer[position++ % size] = data[i];
+    }
+    // Publish the whole record at once
+    head.store(position, std::memory_order_release);
+}
+
+size_t NFCTrace::dump(Print *out)
+{
+    size_t written = 0;
+    if (!header_sent)
+    {
+        written += out->write((const uint8_t *)TRACE_MAGIC, 4);
+        written += out->write((uint8_t)TRACE_VERSION);
+        header_sent = true;
+    }
+
+    size_t position = tail.load(std::memory_order_relaxed);
+    size_t end = head.load(std::memory_order_acquire);
+    while (position < end)
+    {
+        /* Write contiguous chunks up to the end of the ring */
+        size_t start = position % size;
+        size_t chunk = end - position;
+        if (chunk > size - start)
+            chunk = size - start;
+        written += out->write(&buffer[start], chunk);
+        position += chunk;
+    }
+    tail.store(position, std::memory_order_release);
+    return written;
+}
+
+void PN532Replay::begin()
+{
+    if (length < TRACE_HEADER_SIZE || memcmp(trace, TRACE_MAGIC, 4) != 0 || trace[4] != TRACE_VERSION)
+    {
+        LOG_ERROR("Invalid PN532 trace\n");
+        offset = length;
+    }
+}
+
+bool PN532Replay::next_record(uint8_t *direction, uint8_t *len, uint32_t *timestamp, const uint8_t **data)
+{
+    if (offset + TRACE_RECORD_HEADER_SIZE > length)
+        return false;
+    const uint8_t *header = &trace[offset];
+    if (offset + TRACE_RECORD_HEADER_SIZE + header[1] > length)
+        return false;
+    *direction = header[0];
+    *len = header[1];
+    *timestamp = header[2] | (header[3] << 8) | ((uint32_t)header[4] << 16) | ((uint32_t)header[5] << 24);
+    *data = &header[TRACE_RECORD_HEADER_SIZE];
+    offset += TRACE_RECORD_HEADER_SIZE + *len;
+    return true;
+}
+
+int16_t PN532Replay::exchange(const uint8_t *cmd, uint8_t cmd_len, uint8_t *response, uint8_t response_len, uint16_t timeout)
+{
+    uint8_t direction, len;
+    uint32_t command_time, response_time;
+    const uint8_t *data;
+
+    /* Traces attached after NFCFramework was built miss its SAMConfiguration, answer it here */
+    size_t start = offset;
+    bool recorded = next_record(&direction, &len, &command_time, &data) && direction == TRACE_COMMAND;
+    if (cmd_len > 0 && cmd[0] == PN532_COMMAND_SAMCONFIGURATION && (!recorded || len == 0 || data[0] != PN532_COMMAND_SAMCONFIGURATION))
+    {
+        offset = start;
+        return 0;
+    }
+    if (!recorded)
+        return -1;
+    if (len != cmd_len || memcmp(data, cmd, cmd_len) != 0)
+        mismatches++;
+    if (!next_record(&direction, &len, &response_time, &data))
+        return -1;
+    if (realtime)
+        delayMicroseconds(response_time - command_time);
+
+    if (direction == TRACE_ERROR)
+        return len > 0 ? -(int16_t)data[0] : -1;
+    if (len > response_len)
+        len = response_len;
+    memcpy(response, data, len);
+    return len;
+}
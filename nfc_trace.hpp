@@ -0,0 +1,98 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NFC_TRACE_H
+#define NFC_TRACE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "pn532_transport.hpp"
+
+/*
+    Trace format:
+    "PN5T", version(1 byte), then records made of
+    direction(1 byte), length(1 byte), timestamp in us(4 bytes LE), data.
+    Command data starts with the PN532 command code, response data is
+    what follows the response code. Errors have one byte holding the
+    negated transport error.
+*/
+#define TRACE_MAGIC "PN5T"
+#define TRACE_VERSION 1
+#define TRACE_HEADER_SIZE 5
+#define TRACE_RECORD_HEADER_SIZE 6
+#define TRACE_COMMAND 0x01
+#define TRACE_RESPONSE 0x02
+#define TRACE_ERROR 0x03
+#define TRACE_DEFAULT_SIZE 4096
+
+/*
+    Lock free single producer/single consumer ring buffer.
+    The transport records from the task using the framework while
+    another task can dump the trace over serial or to flash.
+    Records that don't fit are dropped and counted.
+*/
+class NFCTrace
+{
+private:
+    uint8_t *buffer;
+    size_t size;
+    std::atomic<size_t> head;   // Written by producer
+    std::atomic<size_t> tail;   // Written by consumer
+    std::atomic<uint32_t> dropped;
+    bool header_sent = false;
+
+    inline size_t used() { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire); };
+public:
+    NFCTrace(size_t _size = TRACE_DEFAULT_SIZE);
+    ~NFCTrace();
+    void record(uint8_t direction, const uint8_t *data, uint8_t len);
+    // Move recorded data to out, the first dump writes the trace header too
+    size_t dump(Print *out);
+    inline uint32_t get_dropped() { return dropped.load(); };
+};
+
+/*
+    Transport answering with the responses of a recorded trace, so a
+    field session can be run again on a bench or on host.
+    With realtime set every response is delayed as in the recording.
+    A SAMConfiguration missing from the trace is answered without using it.
+*/
+class PN532Replay : public PN532Transport
+{
+private:
+    const uint8_t *trace;
+    size_t length;
+    size_t offset = TRACE_HEADER_SIZE;
+    bool realtime;
+    uint32_t mismatches = 0;
+
+    bool next_record(uint8_t *direction, uint8_t *len, uint32_t *timestamp, const uint8_t **data);
+protected:
+    bool is_ready() { return true; };
+    void write_frame(const uint8_t *data, size_t len) {};
+    int16_t read_frame(uint8_t *data, size_t max_len) { return -1; };
+    int16_t exchange(const uint8_t *cmd, uint8_t cmd_len, uint8_t *response, uint8_t response_len, uint16_t timeout);
+public:
+    PN532Replay(const uint8_t *_trace, size_t _length, bool _realtime = false) : trace(_trace), length(_length), realtime(_realtime) {};
+    void begin();
+    void wakeup() {};
+    inline bool finished() { return offset >= length; };
+    // Commands that differ from the recorded ones
+    inline uint32_t get_mismatches() { return mismatches; };
+};
+
+#endif
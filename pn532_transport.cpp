@@ -0,0 +1,333 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pn532_transport.hpp"
+#include "nfc_trace.hpp"
+
+static const uint8_t pn532_ack[] = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
+static const uint8_t pn532_nack[] = {0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00};
+
+bool PN532Transport::wait_ready(uint16_t timeout)
+{
+    unsigned long start = millis();
+    while (!is_ready())
+    {
+        if (timeout != 0 && millis() - start > timeout)
+            return false;
+        delayMicroseconds(PN532_POLL_INTERVAL_US);
+    }
+    return true;
+}
+
+bool PN532Transport::wait_wakeup(uint16_t timeout)
+{
+    unsigned long start = millis();
+    if (irq == 0xFF)
+        return false;
+    while (digitalRead(irq) != LOW)
+    {
+        if (millis() - start > timeout)
+            return false;
+        delay(1);
+    }
+    return true;
+}
+
+bool PN532Transport::read_ack()
+{
+    uint8_t ack[sizeof(pn532_ack)];
+    if (read_frame(ack, sizeof(ack)) != sizeof(ack))
+        return false;
+    return memcmp(ack, pn532_ack, sizeof(pn532_ack)) == 0;
+}
+
+int16_t PN532Transport::command(const uint8_t *cmd, uint8_t cmd_len, uint8_t *response, uint8_t response_len, uint16_t timeout)
+{
+    if (trace == NULL)
+        return exchange(cmd, cmd_len, response, response_len, timeout);
+
+    trace->record(TRACE_COMMAND, cmd, cmd_len);
+    int16_t len = exchange(cmd, cmd_len, response, response_len, timeout);
+    if (len < 0)
+    {
+        uint8_t error = -len;
+        trace->record(TRACE_ERROR, &error, 1);
+    }
+    else
+    {
+        trace->record(TRACE_RESPONSE, response, len);
+    }
+    return len;
+}
+
+int16_t PN532Transport::exchange(const uint8_t *cmd, uint8_t cmd_len, uint8_t *response, uint8_t response_len, uint16_t timeout)
+{
+    if (cmd_len == 0 || cmd_len > PN532_FRAME_MAX - 8)
+        return -1;
+
+    /* Build normal information frame */
+    uint8_t len = cmd_len + 1; // TFI + data
+    uint8_t checksum = PN532_HOSTTOPN532;
+    frame[0] = PN532_PREAMBLE;
+    frame[1] = PN532_STARTCODE1;
+    frame[2] = PN532_STARTCODE2;
+    frame[3] = len;
+    frame[4] = (uint8_t)(~len + 1);
+    frame[5] = PN532_HOSTTOPN532;
+    for (uint8_t i = 0; i < cmd_len; i++)
+    {
+        frame[6 + i] = cmd[i];
+        checksum += cmd[i];
+    }
+    frame[6 + cmd_len] = (uint8_t)(~checksum + 1);
+    frame[7 + cmd_len] = PN532_POSTAMBLE;
+    uint8_t command_code = cmd[0];
+
+    write_frame(frame, cmd_len + 8);
+    if (!wait_ready(timeout) || !read_ack())
+        return -1;
+    if (!wait_ready(timeout))
+    {
+        /* An ACK from the host aborts the running command, otherwise its late answer would be read by the next one */
+        write_frame(pn532_ack, sizeof(pn532_ack));
+        return -2;
+    }
+
+    int16_t frame_len = read_frame(frame, sizeof(frame));
+    if (frame_len < 8)
+        return -3;
+    len = frame[3];
+    if ((uint8_t)(len + frame[4]) != 0 || len < 2 || frame_len < len + 7)
+        return -3;
+    if (frame[5] != PN532_PN532TOHOST || frame[6] != command_code + 1)
+        return -4;
+
+    checksum = 0;
+    for (uint8_t i = 0; i < len; i++)
+    {
+        checksum += frame[5 + i];
+    }
+    if ((uint8_t)(checksum + frame[5 + len]) != 0)
+        return -3;
+
+    // Skip TFI and response code
+    uint8_t data_len = len - 2;
+    if (data_len > response_len)
+        data_len = response_len;
+    memcpy(response, &frame[7], data_len);
+    return data_len;
+}
+
+void PN532SPI::begin()
+{
+    pinMode(ss, OUTPUT);
+    digitalWrite(ss, HIGH);
+    if (spi == NULL)
+    {
+        pinMode(sck, OUTPUT);
+        pinMode(mosi, OUTPUT);
+        pinMode(miso, INPUT);
+        digitalWrite(sck, LOW);
+    }
+    else
+    {
+        spi->begin();
+    }
+}
+
+void PN532SPI::wakeup()
+{
+    /* Holding NSS low wakes up the SPI interface */
+    select();
+    delay(PN532_WAKEUP_DELAY);
+    deselect();
+}
+
+void PN532SPI::select()
+{
+    bus_acquire();
+    if (spi != NULL)
+        spi->beginTransaction(SPISettings(clock, LSBFIRST, SPI_MODE0));
+    digitalWrite(ss, LOW);
+}
+
+void PN532SPI::deselect()
+{
+    digitalWrite(ss, HIGH);
+    if (spi != NULL)
+        spi->endTransaction();
+    bus_release();
+}
+
+uint8_t PN532SPI::transfer(uint8_t data)
+{
+    if (spi != NULL)
+        return spi->transfer(data);
+
+    /* PN532 talks LSB first in SPI mode 0 */
+    uint8_t reply = 0;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        digitalWrite(mosi, (data >> i) & 1);
+        digitalWrite(sck, HIGH);
+        if (digitalRead(miso))
+            reply |= 1 << i;
+        digitalWrite(sck, LOW);
+    }
+    return reply;
+}
+
+bool PN532SPI::is_ready()
+{
+    select();
+    transfer(PN532_SPI_STATREAD);
+    uint8_t status = transfer(0);
+    deselect();
+    return status & PN532_SPI_READY;
+}
+
+void PN532SPI::write_frame(const uint8_t *data, size_t len)
+{
+    select();
+    transfer(PN532_SPI_DATAWRITE);
+#ifdef ESP32
+    if (spi != NULL)
+    {
+        spi->writeBytes(data, len);
+        deselect();
+        return;
+    }
+#endif
+    for (size_t i = 0; i < len; i++)
+    {
+        transfer(data[i]);
+    }
+    deselect();
+}
+
+int16_t PN532SPI::read_frame(uint8_t *data, size_t max_len)
+{
+    if (max_len < 6)
+        return -1;
+    select();
+    transfer(PN532_SPI_DATAREAD);
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        data[i] = transfer(0);
+    }
+
+    /* ACK/NACK frames end right after the postamble, information frames after DCS and postamble */
+    size_t len = (data[3] == 0x00 || data[3] == 0xFF) && (uint8_t)(data[3] + data[4]) == 0xFF ? 6 : 5 + data[3] + 2;
+    if (len > max_len)
+    {
+        deselect();
+        return -1;
+    }
+    if (spi != NULL)
+    {
+        memset(&data[5], 0, len - 5);
+        spi->transfer(&data[5], len - 5);
+    }
+    else
+    {
+        for (size_t i = 5; i < len; i++)
+        {
+            data[i] = transfer(0);
+        }
+    }
+    deselect();
+    return len;
+}
+
+void PN532I2C::begin()
+{
+#ifdef ESP32
+    wire->setBufferSize(PN532_FRAME_MAX + 2);
+#endif
+    wire->setClock(clock);
+    if (irq != 0xFF)
+        pinMode(irq, INPUT_PULLUP);
+}
+
+void PN532I2C::wakeup()
+{
+    /* The PN532 wakes on its own address, first transfer is NACKed */
+    wire->beginTransmission(PN532_I2C_ADDRESS);
+    wire->endTransmission();
+    delay(PN532_WAKEUP_DELAY);
+}
+
+bool PN532I2C::is_ready()
+{
+    if (irq != 0xFF)
+        return digitalRead(irq) == LOW;
+    bus_acquire();
+    bool ready = wire->requestFrom((uint8_t)PN532_I2C_ADDRESS, (size_t)1) == 1 && (wire->read() & PN532_I2C_READY);
+    bus_release();
+    return ready;
+}
+
+void PN532I2C::write_frame(const uint8_t *data, size_t len)
+{
+    bus_acquire();
+    wire->beginTransmission(PN532_I2C_ADDRESS);
+    wire->write(data, len);
+    wire->endTransmission();
+    bus_release();
+}
+
+int16_t PN532I2C::read_frame(uint8_t *data, size_t max_len)
+{
+    /* Every I2C read starts with the status byte, then header and TFI */
+    if (max_len < 6)
+        return -1;
+    bus_acquire();
+    if (wire->requestFrom((uint8_t)PN532_I2C_ADDRESS, (size_t)7) != 7 || !(wire->read() & PN532_I2C_READY))
+    {
+        bus_release();
+        return -1;
+    }
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        data[i] = wire->read();
+    }
+    bus_release();
+    if ((uint8_t)(data[3] + data[4]) == 0xFF && (data[3] == 0x00 || data[3] == 0xFF))
+        return 6;
+
+    size_t len = 5 + data[3] + 2;
+    if (len > max_len)
+        return -1;
+
+    /* Now that the length is known ask the PN532 to send the whole frame again */
+    write_frame(pn532_nack, sizeof(pn532_nack));
+    if (!wait_ready(PN532_DEFAULT_TIMEOUT))
+        return -1;
+    bus_acquire();
+    if (wire->requestFrom((uint8_t)PN532_I2C_ADDRESS, len + 1) != len + 1)
+    {
+        bus_release();
+        return -1;
+    }
+    wire->read(); // Status byte
+    for (size_t i = 0; i < len; i++)
+    {
+        data[i] = wire->read();
+    }
+    bus_release();
+    return len;
+}
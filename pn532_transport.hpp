@@ -0,0 +1,149 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PN532_TRANSPORT_H
+#define PN532_TRANSPORT_H
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <Wire.h>
+#include <mutex>
+
+// PN532 frame definitions
+#define PN532_PREAMBLE 0x00
+#define PN532_STARTCODE1 0x00
+#define PN532_STARTCODE2 0xFF
+#define PN532_POSTAMBLE 0x00
+#define PN532_HOSTTOPN532 0xD4
+#define PN532_PN532TOHOST 0xD5
+#define PN532_FRAME_MAX 262     // Normal information frame with 255 bytes of LEN
+#define PN532_DEFAULT_TIMEOUT 100
+
+// SPI definitions
+#define PN532_SPI_STATREAD 0x02
+#define PN532_SPI_DATAWRITE 0x01
+#define PN532_SPI_DATAREAD 0x03
+#define PN532_SPI_READY 0x01
+#define PN532_SPI_MAX_CLOCK 5000000     // Maximum SCK supported by PN532
+#define PN532_SPI_DEFAULT_CLOCK 1000000
+
+// I2C definitions
+#define PN532_I2C_ADDRESS 0x24
+#define PN532_I2C_READY 0x01
+#define PN532_I2C_STANDARD_CLOCK 100000
+#define PN532_I2C_FAST_CLOCK 400000
+
+class NFCTrace;
+
+// Time between two ready polls while the PN532 is busy
+#define PN532_POLL_INTERVAL_US 100
+// Time needed by PN532 to leave PowerDown
+#define PN532_WAKEUP_DELAY 2
+
+/*
+    Raw command/response link with the PN532.
+    Adafruit_PN532 keeps its own bus handling for the high level
+    functions; this is used where the framework needs the exact frame
+    exchange or a faster clock than the one Adafruit_PN532 hardcodes.
+*/
+class PN532Transport
+{
+protected:
+    // Frame buffer shared by reads and writes, word aligned for frames written from frame[0]. Reads fill it from &frame[5] on
+    uint8_t frame[PN532_FRAME_MAX + 2] __attribute__((aligned(4)));
+    uint8_t irq = 0xFF;
+    NFCTrace *trace = NULL;
+    std::mutex *bus_lock = NULL;
+
+    // Hold the bus for one SPI/I2C transaction, the PN532 processing time runs with the bus free
+    inline void bus_acquire() { if (bus_lock != NULL) bus_lock->lock(); };
+    inline void bus_release() { if (bus_lock != NULL) bus_lock->unlock(); };
+
+    virtual bool is_ready() = 0;
+    virtual void write_frame(const uint8_t *data, size_t len) = 0;
+    // Read a full frame starting from the preamble, return its length or -1
+    virtual int16_t read_frame(uint8_t *data, size_t max_len) = 0;
+
+    bool wait_ready(uint16_t timeout);
+    bool read_ack();
+    // Frame level command/response exchange
+    virtual int16_t exchange(const uint8_t *cmd, uint8_t cmd_len, uint8_t *response, uint8_t response_len, uint16_t timeout);
+public:
+    virtual ~PN532Transport() {};
+    virtual void begin() = 0;
+    // Bring the PN532 out of PowerDown through the host interface
+    virtual void wakeup() = 0;
+    inline bool has_irq() { return irq != 0xFF; };
+    // Wait for the IRQ a PowerDown wake up source raises, false on timeout or without IRQ line
+    virtual bool wait_wakeup(uint16_t timeout);
+    /*
+        Send cmd (command code followed by its parameters) and put the
+        response parameters, without the response code, in response.
+        Return the response length or a negative value on error.
+    */
+    int16_t command(const uint8_t *cmd, uint8_t cmd_len, uint8_t *response, uint8_t response_len, uint16_t timeout = PN532_DEFAULT_TIMEOUT);
+    // Record every command and response in _trace, NULL to stop
+    inline void set_trace(NFCTrace *_trace) { trace = _trace; };
+    // PN532 modules on the same SPI/I2C bus(e.g. different chip selects) must share one lock
+    inline void set_bus_lock(std::mutex *lock) { bus_lock = lock; };
+};
+
+class PN532SPI : public PN532Transport
+{
+private:
+    SPIClass *spi = NULL;   // NULL when bit banging
+    uint8_t sck = 0;
+    uint8_t miso = 0;
+    uint8_t mosi = 0;
+    uint8_t ss;
+    uint32_t clock;
+
+    uint8_t transfer(uint8_t data);
+    void select();
+    void deselect();
+protected:
+    bool is_ready();
+    void write_frame(const uint8_t *data, size_t len);
+    int16_t read_frame(uint8_t *data, size_t max_len);
+public:
+    // Software SPI
+    PN532SPI(uint8_t _sck, uint8_t _miso, uint8_t _mosi, uint8_t _ss) : sck(_sck), miso(_miso), mosi(_mosi), ss(_ss), clock(0) {};
+    // Hardware SPI, clock is capped to PN532_SPI_MAX_CLOCK
+    PN532SPI(uint8_t _ss, SPIClass *_spi, uint32_t _clock = PN532_SPI_DEFAULT_CLOCK) : spi(_spi), ss(_ss), clock(_clock > PN532_SPI_MAX_CLOCK ? PN532_SPI_MAX_CLOCK : _clock) {};
+    void begin();
+    void wakeup();
+    inline uint32_t get_clock() { return clock; };
+};
+
+class PN532I2C : public PN532Transport
+{
+private:
+    TwoWire *wire;
+    uint32_t clock;
+protected:
+    bool is_ready();
+    void write_frame(const uint8_t *data, size_t len);
+    int16_t read_frame(uint8_t *data, size_t max_len);
+public:
+    // Pass irq = 0xFF to poll the status byte instead of the IRQ line
+    PN532I2C(TwoWire *_wire, uint8_t _irq, uint32_t _clock = PN532_I2C_STANDARD_CLOCK) : wire(_wire), clock(_clock) { irq = _irq; };
+    void begin();
+    void wakeup();
+    inline uint32_t get_clock() { return clock; };
+};
+
+#endif
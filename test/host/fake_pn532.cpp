@@ -0,0 +1,465 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fake_pn532.hpp"
+#include "dump_planner.hpp"
+
+#define SIM_AUTH_ERROR -2   // PN532 status 0x14
+
+/*
+    MF1S50 datasheet access tables, written apart from mifare_access.cpp so
+    the tests check the library against the card and not against itself
+*/
+#define SIM_KEY_A 0x01
+#define SIM_KEY_B 0x02
+#define SIM_KEY_AB (SIM_KEY_A | SIM_KEY_B)
+// Data blocks by C1C2C3: read, write, increment, decrement/transfer/restore
+static const uint8_t sim_data_access[8][4] = {
+    {SIM_KEY_AB, SIM_KEY_AB, SIM_KEY_AB, SIM_KEY_AB},   // 000 transport configuration
+    {SIM_KEY_AB, 0, 0, SIM_KEY_AB},                     // 001 value block
+    {SIM_KEY_AB, 0, 0, 0},                              // 010 read only
+    {SIM_KEY_B, SIM_KEY_B, 0, 0},                       // 011
+    {SIM_KEY_AB, SIM_KEY_B, 0, 0},                      // 100
+    {SIM_KEY_B, 0, 0, 0},                               // 101
+    {SIM_KEY_AB, SIM_KEY_B, SIM_KEY_B, SIM_KEY_AB},     // 110 value block
+    {0, 0, 0, 0}                                        // 111
+};
+// Sector trailer by C1C2C3: Key A write, access bits read, access bits write, Key B read, Key B write
+static const uint8_t sim_trailer_access[8][5] = {
+    {SIM_KEY_A, SIM_KEY_A, 0, SIM_KEY_A, SIM_KEY_A},            // 000
+    {SIM_KEY_A, SIM_KEY_A, SIM_KEY_A, SIM_KEY_A, SIM_KEY_A},    // 001 transport configuration
+    {0, SIM_KEY_A, 0, SIM_KEY_A, 0},                            // 010
+    {SIM_KEY_B, SIM_KEY_AB, SIM_KEY_B, 0, SIM_KEY_B},           // 011
+    {SIM_KEY_B, SIM_KEY_AB, 0, 0, SIM_KEY_B},                   // 100
+    {0, SIM_KEY_AB, SIM_KEY_B, 0, 0},                           // 101
+    {0, SIM_KEY_AB, 0, 0, 0},                                   // 110
+    {0, SIM_KEY_AB, 0, 0, 0}                                    // 111
+};
+
+SimType2::SimType2(uint16_t pages) : memory(pages * 4, 0)
+{
+    memcpy(&memory[0], uid, 3);
+    memory[3] = 0x88 ^ uid[0] ^ uid[1] ^ uid[2];
+    memcpy(&memory[4], &uid[3], 4);
+    memory[8] = uid[3] ^ uid[4] ^ uid[5] ^ uid[6];
+}
+
+uint8_t SimType2::target(uint8_t baud, uint8_t *out)
+{
+    if (baud != 0x00)
+        return 0;
+    halted = false;
+    uint8_t header[] = {0x00, 0x44, 0x00, 7};
+    memcpy(out, header, sizeof(header));
+    memcpy(&out[4], uid, 7);
+    return 11;
+}
+
+int16_t SimType2::transceive(const uint8_t *data, uint8_t len, uint8_t *response)
+{
+    uint16_t pages = memory.size() / 4;
+    if (halted || len == 0)
+        return SIM_NO_ANSWER;
+    // Ultralight C key pages can't be read
+    bool hidden = ultralight_c && data[1] >= pages - 4;
+    if (data[0] == 0x30 && len == 2 && data[1] < pages && !hidden)
+    {
+        /* Reads past the last page roll over to page 0 */
+        for (uint8_t i = 0; i < 16; i++)
+            response[i] = memory[(data[1] * 4 + i) % memory.size()];
+        reads++;
+        return 16;
+    }
+    if (data[0] == 0xA2 && len == 6 && data[1] < pages)
+    {
+        memcpy(&memory[data[1] * 4], &data[2], 4);
+        writes++;
+        written_pages.push_back(data[1]);
+        return 0;
+    }
+    if (data[0] == 0x60 && has_version)
+    {
+        memcpy(response, version, 8);
+        return 8;
+    }
+    if (data[0] == 0x1A && ultralight_c)
+    {
+        response[0] = 0xAF;
+        memset(&response[1], 0x5A, 8);
+        return 9;
+    }
+    /* NAK, the card goes back to idle */
+    halted = true;
+    return SIM_NO_ANSWER;
+}
+
+SimClassic::SimClassic(uint16_t _blocks) : blocks_count(_blocks)
+{
+    static const uint8_t default_key[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    static const uint8_t transport_access[4] = {0xFF, 0x07, 0x80, 0x69};
+    memset(blocks, 0, sizeof(blocks));
+    memcpy(blocks[0], uid, 4);
+    blocks[0][4] = uid[0] ^ uid[1] ^ uid[2] ^ uid[3];
+    blocks[0][5] = sak;
+    blocks[0][6] = 0x04;
+    for (uint8_t sector = 0; classic_first_block(sector) < blocks_count; sector++)
+        set_keys(sector, default_key, default_key, transport_access);
+}
+
+void SimClassic::set_keys(uint8_t sector, const uint8_t *key_a, const uint8_t *key_b, const uint8_t *access)
+{
+    uint8_t *trailer = blocks[classic_trailer_block(sector)];
+    memcpy(trailer, key_a, 6);
+    memcpy(&trailer[6], access, 4);
+    memcpy(&trailer[10], key_b, 6);
+}
+
+// Value block: value, ~value, value(LSB first), address, ~address, address, ~address
+static bool sim_value_get(const uint8_t *block, uint32_t *value)
+{
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        if (block[i] != block[8 + i] || block[i] != (uint8_t)~block[4 + i])
+            return false;
+    }
+    if (block[12] != block[14] || block[13] != block[15] || block[12] != (uint8_t)~block[13])
+        return false;
+    *value = block[0] | (block[1] << 8) | (block[2] << 16) | ((uint32_t)block[3] << 24);
+    return true;
+}
+
+static void sim_value_set(uint8_t *block, uint32_t value, uint8_t address)
+{
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        block[i] = block[8 + i] = value >> (8 * i);
+        block[4 + i] = ~block[i];
+    }
+    block[12] = block[14] = address;
+    block[13] = block[15] = ~address;
+}
+
+int8_t SimClassic::condition(uint16_t block)
+{
+    uint8_t sector = classic_sector_of(block);
+    uint8_t offset = block - classic_first_block(sector);
+    uint8_t *trailer = blocks[classic_trailer_block(sector)];
+    uint8_t group = offset == classic_sector_blocks(sector) - 1 ? 3 : classic_sector_blocks(sector) == 4 ? offset : offset / 5;
+
+    /* Byte 6: ~C2 ~C1, byte 7: C1 ~C3, byte 8: C3 C2, one nibble each with a bit per group */
+    uint8_t c1 = trailer[7] >> 4;
+    uint8_t c2 = trailer[8] & 0x0F;
+    uint8_t c3 = trailer[8] >> 4;
+    if ((trailer[6] & 0x0F) != (~c1 & 0x0F) || (trailer[6] >> 4) != (~c2 & 0x0F) || (trailer[7] & 0x0F) != (~c3 & 0x0F))
+        return -1;
+    return (((c1 >> group) & 1) << 2) | (((c2 >> group) & 1) << 1) | ((c3 >> group) & 1);
+}
+
+bool SimClassic::allowed(uint16_t block, uint8_t op)
+{
+    int8_t bits = condition(block);
+    if (auth_sector != classic_sector_of(block) || bits < 0)
+        return false;
+    return sim_data_access[bits][op] & (auth_key_b ? SIM_KEY_B : SIM_KEY_A);
+}
+
+uint8_t SimClassic::target(uint8_t baud, uint8_t *out)
+{
+    if (baud != 0x00)
+        return 0;
+    auth_sector = -1;
+    transfer_ready = false;
+    uint8_t header[] = {0x00, 0x04, sak, 4};
+    memcpy(out, header, sizeof(header));
+    memcpy(&out[4], uid, 4);
+    return 8;
+}
+
+int16_t SimClassic::transceive(const uint8_t *data, uint8_t len, uint8_t *response)
+{
+    if (len < 2 || data[1] >= blocks_count)
+        return SIM_NO_ANSWER;
+    uint16_t block = data[1];
+    uint8_t *trailer = blocks[classic_trailer_block(classic_sector_of(block))];
+
+    if ((data[0] == 0x60 || data[0] == 0x61) && len == 12)
+    {
+        bool key_b = data[0] == 0x61;
+        int8_t bits = condition(classic_trailer_block(classic_sector_of(block)));
+        auths++;
+        auth_sector = -1;
+        transfer_ready = false;
+        // Key B readable from the trailer is plain data
+        if (key_b && bits >= 0 && sim_trailer_access[bits][3])
+            return SIM_AUTH_ERROR;
+        if (memcmp(&data[2], key_b ? &trailer[10] : trailer, 6) != 0 || memcmp(&data[8], uid, 4) != 0)
+            return SIM_AUTH_ERROR;
+        auth_sector = classic_sector_of(block);
+        auth_key_b = key_b;
+        return 0;
+    }
+    bool is_trailer = trailer == blocks[block];
+    uint8_t key = auth_key_b ? SIM_KEY_B : SIM_KEY_A;
+    if (data[0] == 0x30 && len == 2)
+    {
+        if (is_trailer)
+        {
+            /* Key A never leaves the card, access bits and Key B only when allowed */
+            int8_t bits = condition(block);
+            if (auth_sector != classic_sector_of(block) || bits < 0)
+                return SIM_NO_ANSWER;
+            memset(response, 0, 16);
+            if (sim_trailer_access[bits][1] & key)
+                memcpy(&response[6], &trailer[6], 4);
+            if (sim_trailer_access[bits][3] & key)
+                memcpy(&response[10], &trailer[10], 6);
+        }
+        else
+        {
+            if (!allowed(block, 0))
+                return SIM_NO_ANSWER;
+            memcpy(response, blocks[block], 16);
+        }
+        reads++;
+        return 16;
+    }
+    if (data[0] == 0xA0 && len == 18)
+    {
+        if (is_trailer)
+        {
+            /* Only the parts the key may write change */
+            int8_t bits = condition(block);
+            if (auth_sector != classic_sector_of(block) || bits < 0)
+                return SIM_NO_ANSWER;
+            const uint8_t *rights = sim_trailer_access[bits];
+            if (!((rights[0] | rights[2] | rights[4]) & key))
+                return SIM_NO_ANSWER;
+            if (rights[0] & key)
+                memcpy(trailer, &data[2], 6);
+            if (rights[2] & key)
+                memcpy(&trailer[6], &data[8], 4);
+            if (rights[4] & key)
+                memcpy(&trailer[10], &data[12], 6);
+            return 0;
+        }
+        if (!allowed(block, 1))
+            return SIM_NO_ANSWER;
+        memcpy(blocks[block], &data[2], 16);
+        return 0;
+    }
+    if ((data[0] == 0xC0 || data[0] == 0xC1 || data[0] == 0xC2) && len == 6)
+    {
+        uint32_t value;
+        uint8_t op = data[0] == 0xC1 ? 2 : 3;   // Increment or decrement/restore column
+        if (is_trailer || !allowed(block, op) || !sim_value_get(blocks[block], &value))
+            return SIM_NO_ANSWER;
+        uint32_t operand = data[2] | (data[3] << 8) | (data[4] << 16) | ((uint32_t)data[5] << 24);
+        transfer_value = data[0] == 0xC1 ? value + operand : data[0] == 0xC0 ? value - operand : value;
+        transfer_ready = true;
+        return 0;
+    }
+    if (data[0] == 0xB0 && len == 2)
+    {
+        if (is_trailer || !transfer_ready || !allowed(block, 3))
+            return SIM_NO_ANSWER;
+        uint32_t value;
+        uint8_t address = sim_value_get(blocks[block], &value) ? blocks[block][12] : block;
+        sim_value_set(blocks[block], transfer_value, address);
+        transfer_ready = false;
+        transfers++;
+        return 0;
+    }
+    return SIM_NO_ANSWER;
+}
+
+SimFelica::SimFelica()
+{
+    memset(blocks, 0, sizeof(blocks));
+}
+
+uint8_t SimFelica::target(uint8_t baud, uint8_t *out)
+{
+    /* POL_RES length, response code, IDm, PMm, system code */
+    if (baud != 0x01 && baud != 0x02)
+        return 0;
+    out[0] = 20;
+    out[1] = 0x01;
+    memcpy(&out[2], idm, 8);
+    memcpy(&out[10], pmm, 8);
+    out[18] = system_code >> 8;
+    out[19] = system_code;
+    return 20;
+}
+
+int16_t SimFelica::transceive(const uint8_t *data, uint8_t len, uint8_t *response)
+{
+    /* Frames start with their length byte, then command code and IDm */
+    if (len < 11 || data[0] != len || memcmp(&data[2], idm, 8) != 0)
+        return SIM_NO_ANSWER;
+    uint8_t command = data[1];
+    if (command != 0x06 && command != 0x08)
+        return SIM_NO_ANSWER;
+
+    uint8_t services = data[10];
+    if (services != 1 || len < 14 || (data[11] | (data[12] << 8)) != service)
+        return SIM_NO_ANSWER;
+    uint8_t count = data[13];
+    size_t position = 14;
+    uint8_t block_numbers[16];
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (position + 2 > len || count > 16 || (data[position] & 0x80) == 0)
+            return SIM_NO_ANSWER;
+        block_numbers[i] = data[position + 1];
+        position += 2;
+    }
+
+    response[1] = command + 1;
+    memcpy(&response[2], idm, 8);
+    bool too_many = command == 0x06 ? count > max_read : count > max_write;
+    bool bad_block = false;
+    for (uint8_t i = 0; i < count; i++)
+        bad_block |= block_numbers[i] >= 16;
+    response[10] = too_many || bad_block ? 0x01 : 0x00;
+    response[11] = too_many ? 0xA2 : bad_block ? 0xA8 : 0x00;
+    if (response[10] != 0)
+    {
+        response[0] = 12;
+        return 12;
+    }
+
+    if (command == 0x08)
+    {
+        if (position + count * 16 != len)
+            return SIM_NO_ANSWER;
+        for (uint8_t i = 0; i < count; i++)
+            memcpy(blocks[block_numbers[i]], &data[position + i * 16], 16);
+        write_frames++;
+        response[0] = 12;
+        return 12;
+    }
+    response[12] = count;
+    for (uint8_t i = 0; i < count; i++)
+        memcpy(&response[13 + i * 16], blocks[block_numbers[i]], 16);
+    response[0] = 13 + count * 16;
+    return response[0];
+}
+
+std::atomic<int> FakePN532::bus_users(0);
+std::atomic<int> FakePN532::bus_overlaps(0);
+
+void FakePN532::bus_transaction()
+{
+    if (bus_lock == NULL)
+        return;
+    bus_acquire();
+    if (bus_users++ != 0)
+        bus_overlaps++;
+    delayMicroseconds(50);
+    bus_users--;
+    bus_release();
+}
+
+size_t FakePN532::count(uint8_t code)
+{
+    size_t n = 0;
+    for (const std::vector<uint8_t> &command : commands)
+        n += command[0] == code;
+    return n;
+}
+
+bool FakePN532::wait_wakeup(uint16_t timeout)
+{
+    wakeup_waits++;
+    if (asleep && (wakeup_sources & 0x08) && rf_field)   // RF wake up source
+    {
+        asleep = false;
+        return true;
+    }
+    return false;
+}
+
+int16_t FakePN532::exchange(const uint8_t *cmd, uint8_t cmd_len, uint8_t *response, uint8_t response_len, uint16_t timeout)
+{
+    uint8_t answer[PN532_FRAME_MAX];
+    int16_t len = 0;
+    if (asleep)
+        return -1;
+    commands.push_back(std::vector<uint8_t>(cmd, cmd + cmd_len));
+    bus_transaction();
+    if (latency_us != 0)
+        delayMicroseconds(latency_us);
+    bus_transaction();
+
+    switch (cmd[0])
+    {
+    case 0x02: // GetFirmwareVersion: PN532 1.6, every card type
+        answer[0] = 0x32;
+        answer[1] = 0x01;
+        answer[2] = 0x06;
+        answer[3] = 0x07;
+        len = 4;
+        break;
+    case 0x16: // PowerDown
+        answer[0] = 0x00;
+        len = 1;
+        asleep = true;
+        wakeup_sources = cmd[1];
+        break;
+    case 0x40: // InDataExchange
+    {
+        int16_t card_len = card == NULL ? SIM_NO_ANSWER : card->transceive(&cmd[2], cmd_len - 2, &answer[1]);
+        answer[0] = card_len == SIM_AUTH_ERROR ? 0x14 : card_len < 0 ? 0x01 : 0x00;
+        len = card_len < 0 ? 1 : 1 + card_len;
+        break;
+    }
+    case 0x4A: // InListPassiveTarget
+    {
+        uint8_t target_len = card == NULL ? 0 : card->target(cmd[2], &answer[2]);
+        answer[0] = target_len == 0 ? 0 : 1;
+        answer[1] = 1;
+        len = target_len == 0 ? 1 : 2 + target_len;
+        break;
+    }
+    case 0x60: // InAutoPoll
+        if (autopoll.empty())
+        {
+            answer[0] = 0;
+            len = 1;
+        }
+        else
+        {
+            len = autopoll.front().size();
+            memcpy(answer, autopoll.front().data(), len);
+            autopoll.erase(autopoll.begin());
+        }
+        break;
+    case 0x4E: // InPSL
+    case 0x52: // InRelease
+        answer[0] = 0x00;
+        len = 1;
+        break;
+    default:   // SAMConfiguration, RFConfiguration, ...
+        len = 0;
+        break;
+    }
+
+    if (len > response_len)
+        len = response_len;
+    memcpy(response, answer, len);
+    return len;
+}
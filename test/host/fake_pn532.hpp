@@ -0,0 +1,142 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOST_FAKE_PN532_H
+#define HOST_FAKE_PN532_H
+
+#include "pn532_transport.hpp"
+#include "mifare_access.hpp"
+#include <atomic>
+#include <vector>
+
+#define SIM_NO_ANSWER -1    // Card keeps silent, PN532 reports a timeout
+
+// Card in the simulated field
+class SimCard
+{
+public:
+    virtual ~SimCard() {};
+    // InListPassiveTarget target data after Tg for baud, 0 if the card doesn't answer
+    virtual uint8_t target(uint8_t baud, uint8_t *out) = 0;
+    // Answer to a frame sent with InDataExchange, SIM_NO_ANSWER or its length
+    virtual int16_t transceive(const uint8_t *data, uint8_t len, uint8_t *response) = 0;
+};
+
+// NTAG/Ultralight memory, GET_VERSION only when version is set
+class SimType2 : public SimCard
+{
+public:
+    uint8_t uid[7] = {0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+    std::vector<uint8_t> memory;
+    bool has_version = false;
+    uint8_t version[8] = {0};
+    bool ultralight_c = false;  // Answers AUTHENTICATE step 1
+    bool halted = false;        // After a NAK until next selection
+    uint32_t reads = 0;
+    uint32_t writes = 0;
+    std::vector<uint8_t> written_pages;  // In write order
+
+    SimType2(uint16_t pages);
+    uint8_t target(uint8_t baud, uint8_t *out);
+    int16_t transceive(const uint8_t *data, uint8_t len, uint8_t *response);
+};
+
+// Mifare Classic 1K/4K enforcing keys and access bits of its trailers
+class SimClassic : public SimCard
+{
+private:
+    int16_t auth_sector = -1;
+    bool auth_key_b = false;
+    // C1C2C3 of the block group, -1 when the access bytes are broken(the sector is locked)
+    int8_t condition(uint16_t block);
+    // Data block op: 0 read, 1 write, 2 increment, 3 decrement/transfer/restore
+    bool allowed(uint16_t block, uint8_t op);
+public:
+    uint8_t uid[4] = {0xDE, 0xAD, 0xBE, 0xEF};
+    uint8_t sak = 0x08;
+    uint16_t blocks_count;
+    uint8_t blocks[256][16];
+    uint32_t transfer_value = 0;   // Internal register loaded by INCREMENT/DECREMENT/RESTORE
+    bool transfer_ready = false;
+    uint32_t transfers = 0;
+    uint32_t auths = 0;
+    uint32_t reads = 0;
+
+    SimClassic(uint16_t _blocks = 64);
+    // Set both keys and access bits of every trailer
+    void set_keys(uint8_t sector, const uint8_t *key_a, const uint8_t *key_b, const uint8_t *access);
+    uint8_t target(uint8_t baud, uint8_t *out);
+    int16_t transceive(const uint8_t *data, uint8_t len, uint8_t *response);
+};
+
+// FeliCa card with one block list per service
+class SimFelica : public SimCard
+{
+public:
+    uint8_t idm[8] = {0x01, 0x2E, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+    uint8_t pmm[8] = {0x00, 0xF1, 0x00, 0x00, 0x00, 0x01, 0x43, 0x00};
+    uint16_t system_code = 0x88B4;
+    uint16_t service = 0x0009;
+    uint8_t blocks[16][16];
+    uint8_t max_read = 4;
+    uint8_t max_write = 1;
+    uint32_t write_frames = 0;
+
+    SimFelica();
+    uint8_t target(uint8_t baud, uint8_t *out);
+    int16_t transceive(const uint8_t *data, uint8_t len, uint8_t *response);
+};
+
+/*
+    PN532 answering through a simulated field, commands are logged.
+    latency_us delays every answer, as RF and PN532 processing time.
+    Command and response frames take the bus lock like a real bus
+    transaction, overlapping transactions are counted in bus_overlaps.
+*/
+class FakePN532 : public PN532Transport
+{
+private:
+    static std::atomic<int> bus_users;
+    void bus_transaction();
+protected:
+    bool is_ready() { return true; };
+    void write_frame(const uint8_t *data, size_t len) {};
+    int16_t read_frame(uint8_t *data, size_t max_len) { return -1; };
+    int16_t exchange(const uint8_t *cmd, uint8_t cmd_len, uint8_t *response, uint8_t response_len, uint16_t timeout);
+public:
+    SimCard *card = NULL;   // Card in the field, not owned
+    uint32_t latency_us = 0;
+    bool asleep = false;
+    std::vector<std::vector<uint8_t>> commands;
+    // Answers queued for InAutoPoll, an empty one means no card
+    std::vector<std::vector<uint8_t>> autopoll;
+    uint8_t wakeup_sources = 0;     // Of the last PowerDown
+    bool rf_field = false;          // External field, wakes a PN532 waiting for RF
+    uint32_t wakeup_waits = 0;
+
+    static std::atomic<int> bus_overlaps;
+
+    FakePN532(SimCard *_card = NULL) : card(_card) {};
+    void begin() {};
+    void wakeup() { asleep = false; };
+    inline void set_irq(uint8_t pin) { irq = pin; };
+    bool wait_wakeup(uint16_t timeout);
+    // Commands sent with the given command code
+    size_t count(uint8_t code);
+};
+
+#endif
@@ -0,0 +1,61 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test.hpp"
+#include <vector>
+
+struct TestCase
+{
+    const char *name;
+    TestFunction function;
+};
+
+static std::vector<TestCase> &test_cases()
+{
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+TestRegister::TestRegister(const char *name, TestFunction function)
+{
+    test_cases().push_back({name, function});
+}
+
+void test_fail(bool *failed, const char *file, int line, const char *condition)
+{
+    fprintf(stderr, "  %s:%d: CHECK(%s) failed\n", file, line, condition);
+    *failed = true;
+}
+
+// Run every test, or only those whose name contains argv[1]
+int main(int argc, char **argv)
+{
+    size_t run = 0, failures = 0;
+    setvbuf(stdout, NULL, _IONBF, 0);
+    for (const TestCase &test : test_cases())
+    {
+        if (argc > 1 && strstr(test.name, argv[1]) == NULL)
+            continue;
+        bool failed = false;
+        test.function(&failed);
+        printf("%s %s\n", failed ? "FAIL" : "ok  ", test.name);
+        run++;
+        failures += failed;
+    }
+    printf("%zu tests, %zu failed\n", run, failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,43 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOST_MEMORY_STREAM_H
+#define HOST_MEMORY_STREAM_H
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+
+// Stream over a byte vector: writes append, reads consume from the start
+class MemoryStream : public Stream
+{
+public:
+    std::vector<uint8_t> data;
+    size_t position = 0;
+
+    MemoryStream() {};
+    MemoryStream(const std::string &text) : data(text.begin(), text.end()) {};
+    MemoryStream(const uint8_t *bytes, size_t len) : data(bytes, bytes + len) {};
+    size_t write(uint8_t c) { data.push_back(c); return 1; };
+    size_t write(const uint8_t *buffer, size_t size) { data.insert(data.end(), buffer, buffer + size); return size; };
+    int available() { return data.size() - position; };
+    int read() { return position < data.size() ? data[position++] : -1; };
+    int peek() { return position < data.size() ? data[position] : -1; };
+    std::string text() { return std::string(data.begin(), data.end()); };
+};
+
+#endif
@@ -0,0 +1,80 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Adafruit_PN532 with no chip attached: every call fails
+
+#ifndef HOST_ADAFRUIT_PN532_H
+#define HOST_ADAFRUIT_PN532_H
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <Wire.h>
+
+#define PN532_MIFARE_ISO14443A (0x00)
+#define PN532_COMMAND_GETFIRMWAREVERSION (0x02)
+#define PN532_COMMAND_SAMCONFIGURATION (0x14)
+#define PN532_COMMAND_POWERDOWN (0x16)
+#define PN532_COMMAND_RFCONFIGURATION (0x32)
+#define PN532_COMMAND_INDATAEXCHANGE (0x40)
+#define PN532_COMMAND_INLISTPASSIVETARGET (0x4A)
+#define PN532_COMMAND_INPSL (0x4E)
+#define PN532_COMMAND_INRELEASE (0x52)
+#define PN532_COMMAND_INSELECT (0x54)
+#define PN532_COMMAND_INAUTOPOLL (0x60)
+#define MIFARE_CMD_AUTH_A (0x60)
+#define MIFARE_CMD_AUTH_B (0x61)
+#define MIFARE_CMD_READ (0x30)
+#define MIFARE_CMD_WRITE (0xA0)
+#define MIFARE_CMD_TRANSFER (0xB0)
+#define MIFARE_CMD_DECREMENT (0xC0)
+#define MIFARE_CMD_INCREMENT (0xC1)
+#define MIFARE_CMD_STORE (0xC2)
+#define MIFARE_ULTRALIGHT_CMD_WRITE (0xA2)
+
+class Adafruit_PN532
+{
+public:
+    Adafruit_PN532(uint8_t clk, uint8_t miso, uint8_t mosi, uint8_t ss) {};
+    Adafruit_PN532(uint8_t ss, SPIClass *theSPI = &SPI) {};
+    Adafruit_PN532(uint8_t irq, uint8_t reset, TwoWire *theWire = &Wire) {};
+    bool begin() { return false; };
+    void reset() {};
+    void wakeup() {};
+    bool SAMConfig() { return false; };
+    uint32_t getFirmwareVersion() { return 0; };
+    bool sendCommandCheckAck(uint8_t *cmd, uint8_t cmd_len, uint16_t timeout = 100) { return false; };
+    bool setPassiveActivationRetries(uint8_t retries) { return false; };
+    bool readPassiveTargetID(uint8_t baud, uint8_t *uid, uint8_t *uid_length, uint16_t timeout = 0) { return false; };
+    bool readPassiveTargetID(uint8_t baud, uint8_t *uid, uint8_t *uid_length, uint16_t *atqa, uint8_t *sak) { return false; };
+    bool inDataExchange(uint8_t *send, uint8_t send_len, uint8_t *response, uint8_t *response_len) { return false; };
+    uint8_t mifareclassic_AuthenticateBlock(uint8_t *uid, uint8_t uid_len, uint32_t block, uint8_t key_number, uint8_t *key) { return 0; };
+    uint8_t mifareclassic_ReadDataBlock(uint8_t block, uint8_t *data) { return 0; };
+    uint8_t mifareclassic_WriteDataBlock(uint8_t block, uint8_t *data) { return 0; };
+    uint8_t mifareultralight_ReadPage(uint8_t page, uint8_t *buffer) { return 0; };
+    uint8_t mifareultralight_WritePage(uint8_t page, uint8_t *data) { return 0; };
+    uint8_t ntag2xx_ReadPage(uint8_t page, uint8_t *buffer) { return 0; };
+    uint8_t ntag2xx_WritePage(uint8_t page, uint8_t *data) { return 0; };
+    int8_t felica_Polling(uint16_t system_code, uint8_t request_code, uint8_t *idm, uint8_t *pmm, uint16_t *system_code_response, uint16_t timeout) { return -1; };
+    int8_t felica_ReadWithoutEncryption(uint8_t services, uint16_t *service_codes, uint8_t blocks, uint16_t *block_list, uint8_t data[][16]) { return -1; };
+    int8_t felica_WriteWithoutEncryption(uint8_t services, uint16_t *service_codes, uint8_t blocks, uint16_t *block_list, uint8_t data[][16]) { return -1; };
+    int8_t felica_Release() { return -1; };
+    bool AsTarget(uint8_t *uid, uint8_t *felica_params, uint8_t *nfcid3, uint8_t *general_bytes) { return false; };
+    void PrintHex(const byte *data, uint32_t length) {};
+    void PrintHexChar(const byte *data, uint32_t length) {};
+};
+
+#endif
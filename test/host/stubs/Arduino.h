@@ -0,0 +1,98 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Minimal Arduino core to build the library on host
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+typedef uint8_t byte;
+
+#define HEX 16
+#define DEC 10
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define LSBFIRST 0
+#define MSBFIRST 1
+#define HOST_PINS 64
+
+class Print
+{
+private:
+    size_t print_number(unsigned long n, int base);
+public:
+    virtual ~Print() {};
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *str) { return write((const uint8_t *)str, strlen(str)); };
+    size_t print(const char *str) { return write(str); };
+    size_t print(char c) { return write((uint8_t)c); };
+    size_t print(unsigned char n, int base = DEC) { return print_number(n, base); };
+    size_t print(int n, int base = DEC) { return print((long)n, base); };
+    size_t print(unsigned int n, int base = DEC) { return print_number(n, base); };
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC) { return print_number(n, base); };
+    size_t println() { return write("\r\n"); };
+    template <typename T> size_t println(T value) { return print(value) + println(); };
+    template <typename T> size_t println(T value, int base) { return print(value, base) + println(); };
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    size_t readBytes(uint8_t *buffer, size_t length);
+    size_t readBytes(char *buffer, size_t length) { return readBytes((uint8_t *)buffer, length); };
+};
+
+// Serial output is dropped unless NFC_HOST_VERBOSE is set in the environment
+class HardwareSerial : public Stream
+{
+public:
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buffer, size_t size);
+    int available() { return 0; };
+    int read() { return -1; };
+    int peek() { return -1; };
+};
+extern HardwareSerial Serial;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// Pins keep the last written level, tests can drive inputs with host_pin_set
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void host_pin_set(uint8_t pin, uint8_t value);
+
+#endif
@@ -0,0 +1,36 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOST_BERTLV_H
+#define HOST_BERTLV_H
+
+#include <vector>
+#include <string>
+
+#define OK 0
+
+// Finds only top level tags, enough for the EMV answers used in tests
+class BerTlv
+{
+private:
+    std::vector<unsigned char> tlv;
+public:
+    void SetTlv(std::vector<unsigned char> _tlv) { tlv = _tlv; };
+    int GetValue(std::string tag, std::vector<unsigned char> *value);
+};
+
+#endif
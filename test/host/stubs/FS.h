@@ -0,0 +1,87 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+    fs::FS over a plain host directory, same API subset as the ESP32
+    core FS so DumpStore and the exporters run unchanged on host.
+*/
+
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+#include <Arduino.h>
+#include <memory>
+#include <string>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs
+{
+
+enum SeekMode
+{
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2
+};
+
+class File : public Stream
+{
+private:
+    std::shared_ptr<FILE> file;
+public:
+    File() {};
+    File(FILE *_file) : file(_file, fclose) {};
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buffer, size_t size);
+    int available();
+    int read();
+    int peek();
+    size_t read(uint8_t *buffer, size_t size);
+    bool seek(uint32_t position, SeekMode mode = SeekSet);
+    size_t position() const;
+    size_t size() const;
+    void flush();
+    void close() { file.reset(); };
+    operator bool() const { return file != nullptr; };
+};
+
+class FS
+{
+private:
+    std::string base;
+
+    std::string real_path(const char *path);
+public:
+    // Every path is relative to the directory base
+    FS(const char *_base) : base(_base) {};
+    File open(const char *path, const char *mode = FILE_READ, bool create = false);
+    bool exists(const char *path);
+    bool mkdir(const char *path);
+    bool remove(const char *path);
+    bool rename(const char *from, const char *to);
+    bool rmdir(const char *path);
+};
+
+}
+
+using fs::File;
+using fs::FS;
+
+#endif
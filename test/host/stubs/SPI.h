@@ -0,0 +1,45 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include <Arduino.h>
+
+#define SPI_MODE0 0
+
+class SPISettings
+{
+public:
+    SPISettings() {};
+    SPISettings(uint32_t clock, uint8_t bit_order, uint8_t mode) {};
+};
+
+// Bus without devices, every transfer reads 0
+class SPIClass
+{
+public:
+    void begin() {};
+    void beginTransaction(SPISettings settings) {};
+    void endTransaction() {};
+    uint8_t transfer(uint8_t data) { return 0; };
+    void transfer(void *buffer, size_t size) { memset(buffer, 0, size); };
+    void writeBytes(const uint8_t *data, uint32_t size) {};
+};
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,42 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include <Arduino.h>
+
+// Bus without devices, every request is NACKed
+class TwoWire : public Stream
+{
+public:
+    bool begin() { return true; };
+    bool begin(int sda, int scl, uint32_t frequency = 0) { return true; };
+    void setClock(uint32_t clock) {};
+    size_t setBufferSize(size_t size) { return size; };
+    void beginTransmission(uint8_t address) {};
+    uint8_t endTransmission(bool stop = true) { return 2; };
+    size_t requestFrom(uint8_t address, size_t size, bool stop = true) { return 0; };
+    size_t write(uint8_t data) { return 1; };
+    size_t write(const uint8_t *data, size_t size) { return size; };
+    int available() { return 0; };
+    int read() { return -1; };
+    int peek() { return -1; };
+};
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,144 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+#include <chrono>
+#include <thread>
+
+HardwareSerial Serial;
+static uint8_t pins[HOST_PINS];
+static const auto boot = std::chrono::steady_clock::now();
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t written = 0;
+    while (size--)
+    {
+        written += write(*buffer++);
+    }
+    return written;
+}
+
+size_t Print::print_number(unsigned long n, int base)
+{
+    char buffer[sizeof(unsigned long) * 8 + 1];
+    char *str = &buffer[sizeof(buffer) - 1];
+    *str = '\0';
+    if (base < 2)
+        base = 10;
+    do
+    {
+        unsigned long digit = n % base;
+        n /= base;
+        *--str = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    } while (n);
+    return write(str);
+}
+
+size_t Print::print(long n, int base)
+{
+    if (base == DEC && n < 0)
+        return print('-') + print_number(-(unsigned long)n, DEC);
+    return print_number(n, base);
+}
+
+size_t Print::printf(const char *format, ...)
+{
+    char buffer[512];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (len < 0)
+        return 0;
+    return write((const uint8_t *)buffer, (size_t)len < sizeof(buffer) ? len : sizeof(buffer) - 1);
+}
+
+size_t Stream::readBytes(uint8_t *buffer, size_t length)
+{
+    size_t count = 0;
+    while (count < length)
+    {
+        int c = read();
+        if (c < 0)
+            break;
+        buffer[count++] = c;
+    }
+    return count;
+}
+
+static bool verbose()
+{
+    static const bool enabled = getenv("NFC_HOST_VERBOSE") != NULL;
+    return enabled;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    if (verbose())
+        fputc(c, stderr);
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    if (verbose())
+        fwrite(buffer, 1, size, stderr);
+    return size;
+}
+
+unsigned long millis()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - boot).count();
+}
+
+unsigned long micros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - boot).count();
+}
+
+void delay(unsigned long ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin < HOST_PINS && mode == INPUT_PULLUP)
+        pins[pin] = HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    if (pin < HOST_PINS)
+        pins[pin] = value;
+}
+
+int digitalRead(uint8_t pin)
+{
+    return pin < HOST_PINS ? pins[pin] : LOW;
+}
+
+void host_pin_set(uint8_t pin, uint8_t value)
+{
+    digitalWrite(pin, value);
+}
@@ -0,0 +1,61 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BerTlv.h"
+#include <stdlib.h>
+
+int BerTlv::GetValue(std::string tag, std::vector<unsigned char> *value)
+{
+    unsigned long wanted = strtoul(tag.c_str(), NULL, 16);
+    size_t i = 0;
+    while (i < tlv.size())
+    {
+        unsigned long current = tlv[i];
+        if ((tlv[i++] & 0x1F) == 0x1F)
+        {
+            do
+            {
+                if (i >= tlv.size())
+                    return -1;
+                current = (current << 8) | tlv[i];
+            } while (tlv[i++] & 0x80);
+        }
+        if (i >= tlv.size())
+            return -1;
+        size_t len = tlv[i++];
+        if (len & 0x80)
+        {
+            uint8_t bytes = len & 0x7F;
+            len = 0;
+            while (bytes--)
+            {
+                if (i >= tlv.size())
+                    return -1;
+                len = (len << 8) | tlv[i++];
+            }
+        }
+        if (i + len > tlv.size())
+            return -1;
+        if (current == wanted)
+        {
+            value->assign(tlv.begin() + i, tlv.begin() + i + len);
+            return OK;
+        }
+        i += len;
+    }
+    return -1;
+}
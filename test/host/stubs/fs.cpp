@@ -0,0 +1,138 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <FS.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs
+{
+
+size_t File::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t File::write(const uint8_t *buffer, size_t size)
+{
+    if (!file)
+        return 0;
+    return fwrite(buffer, 1, size, file.get());
+}
+
+int File::available()
+{
+    if (!file)
+        return 0;
+    return size() - position();
+}
+
+int File::read()
+{
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::peek()
+{
+    int c = read();
+    if (c >= 0)
+        fseek(file.get(), -1, SEEK_CUR);
+    return c;
+}
+
+size_t File::read(uint8_t *buffer, size_t size)
+{
+    if (!file)
+        return 0;
+    /* Switching from write to read needs a positioning call */
+    fseek(file.get(), 0, SEEK_CUR);
+    return fread(buffer, 1, size, file.get());
+}
+
+bool File::seek(uint32_t position, SeekMode mode)
+{
+    static const int whence[] = {SEEK_SET, SEEK_CUR, SEEK_END};
+    if (!file)
+        return false;
+    return fseek(file.get(), position, whence[mode]) == 0;
+}
+
+size_t File::position() const
+{
+    if (!file)
+        return 0;
+    long position = ftell(file.get());
+    return position < 0 ? 0 : position;
+}
+
+size_t File::size() const
+{
+    struct stat info;
+    if (!file)
+        return 0;
+    fflush(file.get());
+    if (fstat(fileno(file.get()), &info) != 0)
+        return 0;
+    return info.st_size;
+}
+
+void File::flush()
+{
+    if (file)
+        fflush(file.get());
+}
+
+std::string FS::real_path(const char *path)
+{
+    return base + "/" + path;
+}
+
+File FS::open(const char *path, const char *mode, bool create)
+{
+    std::string mode_bin = std::string(mode) + "b";
+    FILE *file = fopen(real_path(path).c_str(), mode_bin.c_str());
+    return file == NULL ? File() : File(file);
+}
+
+bool FS::exists(const char *path)
+{
+    struct stat info;
+    return stat(real_path(path).c_str(), &info) == 0;
+}
+
+bool FS::mkdir(const char *path)
+{
+    return ::mkdir(real_path(path).c_str(), 0755) == 0;
+}
+
+bool FS::remove(const char *path)
+{
+    return unlink(real_path(path).c_str()) == 0;
+}
+
+bool FS::rename(const char *from, const char *to)
+{
+    return ::rename(real_path(from).c_str(), real_path(to).c_str()) == 0;
+}
+
+bool FS::rmdir(const char *path)
+{
+    return ::rmdir(real_path(path).c_str()) == 0;
+}
+
+}
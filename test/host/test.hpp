@@ -0,0 +1,48 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <Arduino.h>
+
+typedef void (*TestFunction)(bool *failed);
+
+struct TestRegister
+{
+    TestRegister(const char *name, TestFunction function);
+};
+
+void test_fail(bool *failed, const char *file, int line, const char *condition);
+
+#define TEST(name)                                                   \
+    static void test_##name(bool *test_failed);                      \
+    static TestRegister register_##name(#name, test_##name);         \
+    static void test_##name(bool *test_failed)
+
+// Stop the test at the first failed check
+#define CHECK(condition)                                             \
+    do                                                               \
+    {                                                                \
+        if (!(condition))                                            \
+        {                                                            \
+            test_fail(test_failed, __FILE__, __LINE__, #condition);  \
+            return;                                                  \
+        }                                                            \
+    } while (0)
+
+#endif
@@ -0,0 +1,47 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "test.hpp"
+#include "fake_pn532.hpp"
+#include "badge_scanner.hpp"
+
+TEST(badge_scanner_keeps_events_past_max_events)
+{
+    SimClassic first;
+    SimClassic second;
+    second.uid[0] = 0x01;
+    FakePN532 *pn532 = new FakePN532(&first);
+    NFCFramework nfc(pn532);
+    BadgeScannerConfig config;
+    config.window = 20;
+    BadgeScanner scanner(&nfc, config);
+    PresenceEvent events[2];
+    CHECK(scanner.begin());
+    CHECK(scanner.poll(events, 2) == 1);
+    CHECK(events[0].type == PRESENCE_ARRIVED);
+
+    // First badge leaves while the second one shows up only for one scan
+    pn532->card = &second;
+    delay(30);
+    CHECK(scanner.poll(events, 1) == 1);
+    CHECK(events[0].type == PRESENCE_REMOVED && events[0].uid[0] == 0xDE);
+    pn532->card = NULL;
+    CHECK(scanner.poll(events, 1) == 1);
+    CHECK(events[0].type == PRESENCE_ARRIVED && events[0].uid[0] == 0x01);
+    CHECK(scanner.poll(events, 2) == 0);
+}
@@ -0,0 +1,116 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test.hpp"
+#include "fake_pn532.hpp"
+#include "nfc_framework.hpp"
+
+TEST(plan_without_get_version_is_ultralight)
+{
+    SimType2 card(16);
+    NFCFramework nfc(new FakePN532(&card));
+    DumpPlan plan;
+    CHECK(nfc.plan_dump(&plan));
+    CHECK(plan.family == CARD_MIFARE_ULTRALIGHT);
+    CHECK(plan.blocks == 16);
+}
+
+TEST(plan_probes_ultralight_c)
+{
+    SimType2 card(ULTRALIGHT_C_PAGES);
+    card.ultralight_c = true;
+    memset(&card.memory[(ULTRALIGHT_C_PAGES - ULTRALIGHT_C_KEY_PAGES) * 4], 0x4B, ULTRALIGHT_C_KEY_PAGES * 4);
+    NFCFramework nfc(new FakePN532(&card));
+    DumpPlan plan;
+    DumpResult result;
+    CHECK(nfc.plan_dump(&plan));
+    CHECK(strcmp(plan.name, "Mifare Ultralight C") == 0);
+    CHECK(plan.blocks == ULTRALIGHT_C_PAGES);
+    uint8_t *dump = nfc.dump_tag(&plan, (Key *)NULL, &result);
+    CHECK(dump != NULL);
+    CHECK(result.unreadable == 0);
+    CHECK(card.reads == (ULTRALIGHT_C_PAGES - ULTRALIGHT_C_KEY_PAGES) / 4);
+    const uint8_t zero[ULTRALIGHT_C_KEY_PAGES * 4] = {0};
+    CHECK(memcmp(&dump[(ULTRALIGHT_C_PAGES - ULTRALIGHT_C_KEY_PAGES) * 4], zero, sizeof(zero)) == 0);
+    free(dump);
+}
+
+TEST(plan_rejects_oversized_type2_storage)
+{
+    uint8_t uid[7] = {0x04, 1, 2, 3, 4, 5, 6};
+    // Header, vendor, product type, subtype, major, minor, storage size, protocol
+    uint8_t version[GET_VERSION_SIZE] = {0x00, 0x04, 0x05, 0x02, 0x01, 0x00, 0x13, 0x03};
+    DumpPlan plan;
+    CHECK(dump_plan_build(0x0044, 0x00, uid, 7, version, &plan));
+    CHECK(plan.blocks == 132);
+    // 1024 bytes would need SECTOR_SELECT, 0xFF would overflow the shift
+    version[6] = 0x15;
+    CHECK(!dump_plan_build(0x0044, 0x00, uid, 7, version, &plan));
+    version[6] = 0xFF;
+    CHECK(!dump_plan_build(0x0044, 0x00, uid, 7, version, &plan));
+}
+
+TEST(legacy_dump_follows_classic_plan)
+{
+    SimClassic card(20);
+    card.sak = 0x09;
+    for (uint16_t block = 1; block < 20; block++)
+    {
+        if (block % 4 != 3)
+            memset(card.blocks[block], block, 16);
+    }
+    NFCFramework nfc(new FakePN532(&card));
+    uint8_t key[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    size_t uid_length = 0;
+    DumpResult result;
+
+    uint8_t *dump = nfc.dump_tag(key, &uid_length, &result);
+    CHECK(dump != NULL);
+    CHECK(uid_length == 4);
+    CHECK(result.unreadable == 0 && result.unauthenticated == 0);
+    CHECK(memcmp(&dump[18 * 16], card.blocks[18], 16) == 0);
+    free(dump);
+
+    /* Keys for the first 8 blocks only */
+    Key keys[2] = {{KEY_A, {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}}, {KEY_A, {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}}};
+    dump = nfc.dump_tag(keys, 8, &result);
+    CHECK(dump != NULL);
+    CHECK(result.unauthenticated == 12);
+    CHECK(memcmp(&dump[5 * 16], card.blocks[5], 16) == 0);
+    free(dump);
+}
+
+TEST(legacy_dump_keeps_page_stride)
+{
+    SimType2 card(45);
+    card.has_version = true;
+    uint8_t version[8] = {0x00, 0x04, 0x04, 0x02, 0x01, 0x00, 0x0F, 0x03};
+    memcpy(card.version, version, 8);
+    for (size_t i = 16; i < card.memory.size(); i++)
+        card.memory[i] = i;
+    NFCFramework nfc(new FakePN532(&card));
+    uint8_t key[6] = {0};
+    size_t uid_length = 0;
+    DumpResult result;
+
+    uint8_t *dump = nfc.dump_tag(key, &uid_length, &result);
+    CHECK(dump != NULL);
+    CHECK(uid_length == 7);
+    CHECK(memcmp(&dump[44 * 16], &card.memory[44 * 4], 4) == 0);
+    CHECK(dump[44 * 16 + 4] == 0);
+    free(dump);
+}
@@ -0,0 +1,172 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <filesystem>
+#include <string>
+#include "test.hpp"
+#include "dump_store.hpp"
+
+// Store on a fresh host directory, removed with the fixture
+class StoreFixture
+{
+public:
+    std::string dir;
+    fs::FS *fs;
+    DumpStore *store;
+
+    StoreFixture() {
+        char pattern[] = "/tmp/dump_store_XXXXXX";
+        dir = mkdtemp(pattern);
+        fs = new fs::FS(dir.c_str());
+        store = new DumpStore(fs, "/dumps");
+    };
+    ~StoreFixture() {
+        delete store;
+        delete fs;
+        std::filesystem::remove_all(dir);
+    };
+};
+
+// Classic 1K dump with distinct blocks, block 0 is the card own
+static NFCTag *classic_tag(uint8_t uid0, uint8_t seed)
+{
+    DumpPlan plan;
+    dump_plan_classic_blocks(&plan, 64);
+    uint8_t *image = (uint8_t *)malloc(dump_plan_image_size(&plan));
+    for (size_t i = 0; i < dump_plan_image_size(&plan); i++)
+        image[i] = i / BLOCK_SIZE + seed;
+    const uint8_t block0[] = {uid0, 0xAD, 0xBE, 0xEF, (uint8_t)(uid0 ^ 0xAD ^ 0xBE ^ 0xEF), 0x08, 0x04, 0x00};
+    memcpy(image, block0, sizeof(block0));
+    memcpy(plan.uid, block0, 4);
+    plan.uid_length = 4;
+    plan.atqa = 0x0004;
+    plan.sak = 0x08;
+    return new NFCTag(image, &plan);
+}
+
+static void free_tag(NFCTag *tag)
+{
+    free(tag->get_data());
+    free(tag->get_uid());
+    delete tag;
+}
+
+TEST(store_round_trip_keeps_legacy_atqa)
+{
+    StoreFixture fixture;
+    CHECK(fixture.store->begin());
+    static uint8_t dump[MIFARE_CLASSIC_SIZE] = {0xDE, 0xAD, 0xBE, 0xEF, 0x22, 0x08, 0x04, 0x00};
+    dump[16] = 0x42;
+    NFCTag *legacy = new NFCTag(dump, 4);
+    bool saved = fixture.store->save(legacy);
+    free_tag(legacy);
+    CHECK(saved);
+
+    NFCTag *tag = fixture.store->load(dump, 4);
+    CHECK(tag != NULL);
+    uint8_t atqa[2];
+    uint8_t block[BLOCK_SIZE];
+    tag->get_atqa(atqa);
+    tag->get_block(1, block);
+    uint8_t sak = tag->get_sak();
+    free_tag(tag);
+    CHECK(atqa[0] == 0x00 && atqa[1] == 0x04);
+    CHECK(sak == 0x08);
+    CHECK(block[0] == 0x42);
+}
+
+TEST(store_shares_identical_blocks)
+{
+    StoreFixture fixture;
+    CHECK(fixture.store->begin());
+    NFCTag *first = classic_tag(0x01, 0);
+    NFCTag *second = classic_tag(0x02, 0);
+    CHECK(fixture.store->save(first));
+    CHECK(fixture.store->save(second));
+    free_tag(first);
+    free_tag(second);
+    // Only block 0 differs
+    CHECK(fixture.store->pool_chunks() == 65);
+}
+
+TEST(store_reuses_chunks_of_removed_dumps)
+{
+    StoreFixture fixture;
+    const uint8_t uid[] = {0x01, 0xAD, 0xBE, 0xEF};
+    CHECK(fixture.store->begin());
+    NFCTag *tag = classic_tag(0x01, 0);
+    CHECK(fixture.store->save(tag));
+    CHECK(fixture.store->save(tag));   // Replacing a dump keeps the count right
+    free_tag(tag);
+    CHECK(fixture.store->used_chunks() == 64);
+
+    // Counts survive a restart
+    fixture.store->end();
+    CHECK(fixture.store->begin());
+    CHECK(fixture.store->remove(uid, sizeof(uid)));
+    CHECK(fixture.store->used_chunks() == 0);
+
+    tag = classic_tag(0x03, 100);
+    CHECK(fixture.store->save(tag));
+    free_tag(tag);
+    CHECK(fixture.store->pool_chunks() == 64);
+    CHECK(fixture.store->used_chunks() == 64);
+    fixture.store->end();
+    CHECK(fixture.store->begin());
+    const uint8_t other[] = {0x03, 0xAD, 0xBE, 0xEF};
+    tag = fixture.store->load(other, sizeof(other));
+    CHECK(tag != NULL);
+    uint8_t block[BLOCK_SIZE];
+    tag->get_block(5, block);
+    free_tag(tag);
+    CHECK(block[0] == 105);
+}
+
+// Bytes of every bucket file
+static size_t buckets_size(StoreFixture *fixture)
+{
+    size_t size = 0;
+    for (const auto &bucket : std::filesystem::directory_iterator(fixture->dir + "/dumps/h"))
+        size += bucket.file_size();
+    return size;
+}
+
+TEST(store_compacts_buckets_of_freed_chunks)
+{
+    StoreFixture fixture;
+    CHECK(fixture.store->begin());
+    // Same card with two contents in turn, each save frees the slots the other one takes
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        NFCTag *tag = classic_tag(0x01, i % 2 == 0 ? 0 : 100);
+        CHECK(fixture.store->save(tag));
+        free_tag(tag);
+        CHECK(buckets_size(&fixture) == fixture.store->used_chunks() * 8);
+    }
+    CHECK(fixture.store->pool_chunks() <= 128);
+
+    const uint8_t uid[] = {0x01, 0xAD, 0xBE, 0xEF};
+    NFCTag *tag = fixture.store->load(uid, sizeof(uid));
+    CHECK(tag != NULL);
+    uint8_t block[BLOCK_SIZE];
+    tag->get_block(5, block);
+    free_tag(tag);
+    CHECK(block[0] == 105);
+    CHECK(fixture.store->remove(uid, sizeof(uid)));
+    CHECK(buckets_size(&fixture) == 0);
+}
@@ -0,0 +1,122 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <string>
+#include "test.hpp"
+#include "memory_stream.hpp"
+#include "NFCTag.hpp"
+#include "nfc_export.hpp"
+
+static NFCTag *paged_tag(const char *name, uint16_t pages)
+{
+    DumpPlan plan;
+    dump_plan_pages(&plan, name, CARD_NTAG, pages);
+    plan.uid_length = 7;
+    plan.atqa = 0x0044;
+    return new NFCTag((uint8_t *)calloc(dump_plan_image_size(&plan), 1), &plan);
+}
+
+// NFCTag doesn't own its buffers, the caller frees them
+static void free_tag(NFCTag *tag)
+{
+    free(tag->get_data());
+    free(tag->get_uid());
+    delete tag;
+}
+
+TEST(flipper_export_has_ultralight_fields)
+{
+    NFCTag *tag = paged_tag("NTAG213", 45);
+    MemoryStream out;
+    export_flipper(tag, &out);
+    std::string text = out.text();
+    CHECK(text.find("NTAG/Ultralight type: NTAG213\n") != std::string::npos);
+    CHECK(text.find("Signature: 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00\n") != std::string::npos);
+    CHECK(text.find("Mifare version: 00 04 04 02 01 00 0F 03\n") != std::string::npos);
+    CHECK(text.find("Counter 2: 0\nTearing 2: 00\nPages total: 45\n") != std::string::npos);
+    CHECK(text.find("Page 44: 00 00 00 00\nFailed authentication attempts: 0\n") != std::string::npos);
+
+    MemoryStream in(text);
+    NFCTag *imported = import_flipper(&in);
+    CHECK(imported != NULL);
+    CHECK(strcmp(imported->get_name(), "NTAG213") == 0);
+    CHECK(imported->get_blocks_count() == 45);
+    free_tag(imported);
+    free_tag(tag);
+}
+
+TEST(flipper_export_maps_unknown_types_to_ultralight)
+{
+    const char *names[] = {"Type 2 tag", "NTAG212", "Mifare Ultralight EV1 MF0UL21"};
+    const char *expected[] = {"Mifare Ultralight\n", "Mifare Ultralight\n", "Mifare Ultralight 21\n"};
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        NFCTag *tag = paged_tag(names[i], 41);
+        MemoryStream out;
+        export_flipper(tag, &out);
+        bool found = out.text().find(std::string("NTAG/Ultralight type: ") + expected[i]) != std::string::npos;
+        free_tag(tag);
+        CHECK(found);
+    }
+}
+
+TEST(legacy_classic_tag_reads_block_0)
+{
+    static uint8_t dump[MIFARE_CLASSIC_SIZE] = {0xDE, 0xAD, 0xBE, 0xEF, 0x22, 0x08, 0x04, 0x00};
+    NFCTag *tag = new NFCTag(dump, 4);
+    uint8_t atqa[2];
+    tag->get_atqa(atqa);
+    uint8_t bcc = tag->get_bcc();
+    uint8_t sak = tag->get_sak();
+    free_tag(tag);
+    CHECK(bcc == 0x22);
+    CHECK(sak == 0x08);
+    CHECK(atqa[0] == 0x00 && atqa[1] == 0x04);
+}
+
+TEST(legacy_ultralight_tag_has_fixed_anticollision)
+{
+    static uint8_t dump[MIFARE_ULTRALIGHT_SIZE] = {0x04, 0x11, 0x22, 0x9F};
+    dump[8] = 0x55;
+    NFCTag *tag = new NFCTag(dump, 7);
+    uint8_t atqa[2];
+    tag->get_atqa(atqa);
+    uint8_t sak = tag->get_sak();
+    free_tag(tag);
+    CHECK(sak == 0x00);
+    CHECK(atqa[0] == 0x00 && atqa[1] == 0x44);
+}
+
+TEST(import_mfd_takes_only_known_sizes)
+{
+    static uint8_t image[1024];
+    MemoryStream odd(image, 224);
+    CHECK(import_mfd(&odd, 224) == NULL);
+    MemoryStream ntag(image, 180);
+    NFCTag *tag = import_mfd(&ntag, 180);
+    CHECK(tag != NULL);
+    size_t pages = tag->get_blocks_count();
+    free_tag(tag);
+    CHECK(pages == 45);
+    MemoryStream classic(image, 1024);
+    tag = import_mfd(&classic, 1024);
+    CHECK(tag != NULL);
+    size_t blocks = tag->get_blocks_count();
+    free_tag(tag);
+    CHECK(blocks == 64);
+}
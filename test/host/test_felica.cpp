@@ -0,0 +1,97 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "test.hpp"
+#include "fake_pn532.hpp"
+#include "NFCTag.hpp"
+
+// Image of card with block i filled with i + 1
+static NFCTag *felica_image(SimFelica *card, uint8_t ic)
+{
+    uint8_t pmm[8];
+    uint8_t data[FELICA_DUMP_BLOCKS][16];
+    memcpy(pmm, card->pmm, sizeof(pmm));
+    pmm[1] = ic;
+    for (uint8_t i = 0; i < FELICA_DUMP_BLOCKS; i++)
+        memset(data[i], i + 1, 16);
+    return new NFCTag(card->idm, pmm, card->system_code, data);
+}
+
+static void free_tag(NFCTag *tag)
+{
+    free(tag->get_uid());
+    free(tag->get_pmm());
+    delete tag;
+}
+
+TEST(felica_restore_writes_lite_image)
+{
+    SimFelica card;
+    FakePN532 *pn532 = new FakePN532(&card);
+    NFCFramework nfc(pn532);
+    NFCTag *tag = felica_image(&card, FELICA_IC_LITE_S);
+    FelicaWriteResult result;
+    bool restored = nfc.felica_restore(tag, &result);
+    free_tag(tag);
+    CHECK(restored);
+    CHECK(result.verified == FELICA_DUMP_BLOCKS);
+    CHECK(result.frames == FELICA_DUMP_BLOCKS);
+    CHECK(card.blocks[13][0] == 14);
+    // The IC check and the write share one polling
+    CHECK(pn532->count(PN532_COMMAND_INLISTPASSIVETARGET) == 1);
+}
+
+TEST(felica_restore_refuses_other_ics)
+{
+    SimFelica card;
+    NFCFramework nfc(new FakePN532(&card));
+    FelicaWriteResult result;
+    NFCTag *tag = felica_image(&card, 0x32);
+    bool restored = nfc.felica_restore(tag, &result);
+    free_tag(tag);
+    CHECK(!restored);
+
+    // Lite image, but another card in the field
+    card.pmm[1] = 0x32;
+    tag = felica_image(&card, FELICA_IC_LITE);
+    restored = nfc.felica_restore(tag, &result);
+    free_tag(tag);
+    CHECK(!restored);
+    CHECK(card.write_frames == 0);
+}
+
+TEST(felica_restore_takes_services)
+{
+    SimFelica card;
+    card.pmm[1] = 0x32;
+    card.max_read = FELICA_MAX_BLOCKS_PER_READ;
+    card.max_write = FELICA_MAX_BLOCKS_PER_WRITE;
+    FakePN532 *pn532 = new FakePN532(&card);
+    NFCFramework nfc(pn532);
+    uint16_t services[FELICA_DUMP_BLOCKS];
+    for (uint8_t i = 0; i < FELICA_DUMP_BLOCKS; i++)
+        services[i] = card.service;
+    NFCTag *tag = felica_image(&card, 0x32);
+    FelicaWriteResult result;
+    bool restored = nfc.felica_restore(tag, &result, services);
+    free_tag(tag);
+    CHECK(restored);
+    CHECK(result.frames == 2);
+    CHECK(card.blocks[0][0] == 1);
+    CHECK(pn532->count(PN532_COMMAND_INLISTPASSIVETARGET) == 1);
+}
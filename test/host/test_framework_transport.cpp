@@ -0,0 +1,122 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test.hpp"
+#include "fake_pn532.hpp"
+#include "memory_stream.hpp"
+#include "nfc_framework.hpp"
+
+TEST(custom_transport_runs_generic_functions)
+{
+    SimClassic card;
+    FakePN532 *pn532 = new FakePN532(&card);
+    NFCFramework nfc(pn532);
+    uint8_t uid[7];
+    uint8_t uid_length = 0;
+    uint8_t key[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    uint8_t block[16];
+
+    // Out of LowVbat mode before anything else
+    CHECK(pn532->commands.size() == 1 && pn532->commands[0][0] == PN532_COMMAND_SAMCONFIGURATION);
+    CHECK(nfc.ready());
+    CHECK(nfc.get_version() == 0x32010607);
+    CHECK(nfc.get_tag_uid(uid, &uid_length) == 1);
+    CHECK(uid_length == 4 && memcmp(uid, card.uid, 4) == 0);
+    memset(block, 0x42, sizeof(block));
+    CHECK(nfc.write_tag(1, block, KEY_A, key));
+    CHECK(memcmp(card.blocks[1], block, 16) == 0);
+    memset(block, 0, sizeof(block));
+    CHECK(nfc.read_block(1, key, KEY_A, block));
+    CHECK(block[15] == 0x42);
+    CHECK(!nfc.emulate_tag(uid));
+}
+
+TEST(custom_transport_runs_felica_functions)
+{
+    SimFelica card;
+    NFCFramework nfc(new FakePN532(&card));
+    uint8_t idm[8], pmm[8];
+    uint16_t system_code = 0;
+    uint16_t service = FELICA_LITE_SERVICE_RW;
+    uint16_t block_list[2] = {0x8000, 0x8003};
+    uint8_t data[2][16];
+
+    CHECK(nfc.felica_polling(idm, pmm, &system_code) == 1);
+    CHECK(memcmp(idm, card.idm, 8) == 0);
+    CHECK(system_code == card.system_code);
+    memset(data[0], 0xA5, 16);
+    CHECK(nfc.felica_write_without_encryption(1, &service, 1, &block_list[1], data) == 1);
+    CHECK(card.blocks[3][0] == 0xA5);
+    memset(data, 0, sizeof(data));
+    CHECK(nfc.felica_read_without_encryption(1, &service, 2, block_list, data) == 1);
+    CHECK(data[1][15] == 0xA5 && data[0][0] == 0);
+}
+
+/* GetFirmwareVersion and InListPassiveTarget captured on a PN532 v1.6 with a Classic 1K */
+static const uint8_t captured[] = {
+    'P', 'N', '5', 'T', 0x01,
+    0x01, 0x01, 0x10, 0x27, 0x00, 0x00, 0x02,
+    0x02, 0x04, 0x40, 0x2A, 0x00, 0x00, 0x32, 0x01, 0x06, 0x07,
+    0x01, 0x03, 0x00, 0x35, 0x00, 0x00, 0x4A, 0x01, 0x00,
+    0x02, 0x0A, 0x60, 0x8C, 0x00, 0x00, 0x01, 0x01, 0x00, 0x04, 0x08, 0x04, 0x9C, 0x27, 0xE1, 0x4D,
+};
+
+TEST(replay_reproduces_captured_trace)
+{
+    PN532Replay *replay = new PN532Replay(captured, sizeof(captured), true);
+    NFCFramework nfc(replay);
+    uint8_t uid[7];
+    uint8_t uid_length = 0;
+
+    unsigned long start = micros();
+    CHECK(nfc.get_version() == 0x32010607);
+    CHECK(nfc.get_tag_uid(uid, &uid_length) == 1);
+    CHECK(uid_length == 4 && uid[0] == 0x9C && uid[3] == 0x4D);
+    // Responses keep the recorded timing: 0.8ms + 22.4ms
+    CHECK(micros() - start >= 20000);
+    CHECK(replay->finished());
+    CHECK(replay->get_mismatches() == 0);
+}
+
+TEST(replay_reproduces_recorded_session)
+{
+    SimClassic card;
+    memset(card.blocks[8], 0x17, 16);
+    NFCTrace trace(16384);
+    NFCFramework recorder(new FakePN532(&card));
+    uint8_t key[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    size_t uid_length;
+    DumpResult result;
+
+    recorder.set_trace(&trace);
+    uint8_t *recorded = recorder.dump_tag(key, &uid_length, &result);
+    CHECK(recorded != NULL);
+    MemoryStream capture;
+    trace.dump(&capture);
+    CHECK(trace.get_dropped() == 0);
+
+    PN532Replay *replay = new PN532Replay(capture.data.data(), capture.data.size());
+    NFCFramework replayed(replay);
+    uint8_t *dump = replayed.dump_tag(key, &uid_length, &result);
+    CHECK(dump != NULL);
+    CHECK(memcmp(dump, recorded, MIFARE_CLASSIC_SIZE) == 0);
+    CHECK(dump[8 * 16] == 0x17);
+    CHECK(replay->get_mismatches() == 0);
+    CHECK(replay->finished());
+    free(recorded);
+    free(dump);
+}
@@ -0,0 +1,118 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <vector>
+#include "test.hpp"
+#include "fake_pn532.hpp"
+#include "nfc_framework.hpp"
+
+// Smart card wanting Le = 0x10, it answers 6C10 to any other APDU
+class SimLeCard : public SimCard
+{
+public:
+    std::vector<std::vector<uint8_t>> apdus;
+
+    uint8_t target(uint8_t baud, uint8_t *out) { return 0; };
+    int16_t transceive(const uint8_t *data, uint8_t len, uint8_t *response) {
+        apdus.push_back(std::vector<uint8_t>(data, data + len));
+        if (apdus.size() == 1)
+        {
+            response[0] = 0x6C;
+            response[1] = 0x10;
+            return 2;
+        }
+        memset(response, 0xAB, 16);
+        response[16] = 0x90;
+        response[17] = 0x00;
+        return 18;
+    };
+};
+
+static std::vector<uint8_t> retried(const std::vector<uint8_t> &apdu)
+{
+    SimLeCard card;
+    NFCFramework nfc(new FakePN532(&card));
+    uint8_t response[32];
+    if (nfc.apdu_exchange(apdu.data(), apdu.size(), response, sizeof(response)) != 18 || card.apdus.size() != 2)
+        return std::vector<uint8_t>();
+    return card.apdus[1];
+}
+
+TEST(wrong_le_retry_follows_apdu_case)
+{
+    // Case 1 and 3 get Le appended, 2 and 4 get it replaced
+    CHECK(retried({0x00, 0xB0, 0x00, 0x00}) == std::vector<uint8_t>({0x00, 0xB0, 0x00, 0x00, 0x10}));
+    CHECK(retried({0x00, 0xB0, 0x00, 0x00, 0x00}) == std::vector<uint8_t>({0x00, 0xB0, 0x00, 0x00, 0x10}));
+    CHECK(retried({0x00, 0xA4, 0x04, 0x00, 0x02, 0x3F, 0x00}) == std::vector<uint8_t>({0x00, 0xA4, 0x04, 0x00, 0x02, 0x3F, 0x00, 0x10}));
+    CHECK(retried({0x00, 0xA4, 0x04, 0x00, 0x02, 0x3F, 0x00, 0x00}) == std::vector<uint8_t>({0x00, 0xA4, 0x04, 0x00, 0x02, 0x3F, 0x00, 0x10}));
+    CHECK(retried({0x00, 0xB0, 0x00, 0x00, 0x00, 0x01, 0x00}) == std::vector<uint8_t>({0x00, 0xB0, 0x00, 0x00, 0x00, 0x00, 0x10}));
+    CHECK(retried({0x00, 0xD6, 0x00, 0x00, 0x00, 0x00, 0x02, 0xAA, 0xBB}) ==
+          std::vector<uint8_t>({0x00, 0xD6, 0x00, 0x00, 0x00, 0x00, 0x02, 0xAA, 0xBB, 0x00, 0x10}));
+    CHECK(retried({0x00, 0x2A, 0x00, 0x00, 0x00, 0x00, 0x02, 0xAA, 0xBB, 0x00, 0x00}) ==
+          std::vector<uint8_t>({0x00, 0x2A, 0x00, 0x00, 0x00, 0x00, 0x02, 0xAA, 0xBB, 0x00, 0x10}));
+}
+
+TEST(wrong_le_retry_rejects_malformed_apdu)
+{
+    // Lc says 4 bytes, 2 follow
+    CHECK(retried({0x00, 0xA4, 0x04, 0x00, 0x04, 0x3F, 0x00}).empty());
+}
+
+// ISO14443-4 card whose ATS carries the given TA(1)
+class SimAtsCard : public SimCard
+{
+public:
+    uint8_t ta;
+
+    SimAtsCard(uint8_t ta) : ta(ta) {};
+    uint8_t target(uint8_t baud, uint8_t *out) {
+        const uint8_t data[] = {0x00, 0x04, 0x20, 0x04, 0x01, 0x02, 0x03, 0x04, 0x05, 0x78, ta, 0x80, 0x02};
+        memcpy(out, data, sizeof(data));
+        return sizeof(data);
+    };
+    int16_t transceive(const uint8_t *data, uint8_t len, uint8_t *response) { return SIM_NO_ANSWER; };
+};
+
+// Select the card and count the InPSL it got, psl is SIZE_MAX if the select fails
+static IsoDepInfo selected(uint8_t ta, uint8_t max_rate, size_t *psl)
+{
+    SimAtsCard card(ta);
+    FakePN532 *pn532 = new FakePN532(&card);
+    NFCFramework nfc(pn532);
+    IsoDepInfo info;
+    *psl = nfc.iso_dep_select(&info, max_rate) ? pn532->count(PN532_COMMAND_INPSL) : SIZE_MAX;
+    return info;
+}
+
+TEST(iso_dep_rates_only_advertised_by_card)
+{
+    size_t psl;
+    // DR and DS list 424 kbps only: a 212 kbps cap must leave the card at 106
+    IsoDepInfo info = selected(0x22, ISO_DEP_212, &psl);
+    CHECK(info.send_rate == ISO_DEP_106 && info.receive_rate == ISO_DEP_106 && psl == 0);
+    info = selected(0x22, ISO_DEP_424, &psl);
+    CHECK(info.send_rate == ISO_DEP_424 && info.receive_rate == ISO_DEP_424 && psl == 1);
+    // 212 and 424 kbps to the card, 424 kbps only back
+    info = selected(0x23, ISO_DEP_212, &psl);
+    CHECK(info.send_rate == ISO_DEP_212 && info.receive_rate == ISO_DEP_106 && psl == 1);
+    // Same rate both ways: 212 kbps isn't listed for receive, 424 is common
+    info = selected(0xA3, ISO_DEP_424, &psl);
+    CHECK(info.send_rate == ISO_DEP_424 && info.receive_rate == ISO_DEP_424 && psl == 1);
+    info = selected(0xA3, ISO_DEP_212, &psl);
+    CHECK(info.send_rate == ISO_DEP_106 && info.receive_rate == ISO_DEP_106 && psl == 0);
+}
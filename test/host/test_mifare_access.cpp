@@ -0,0 +1,166 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "test.hpp"
+#include "fake_pn532.hpp"
+#include "nfc_framework.hpp"
+
+static const uint8_t default_key[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+// Access bytes 6-9 of a trailer, conditions are C1C2C3 of each group
+static void encode_access(const uint8_t *conditions, uint8_t *out)
+{
+    memset(out, 0, 4);
+    for (uint8_t group = 0; group < 4; group++)
+    {
+        uint8_t c1 = (conditions[group] >> 2) & 1;
+        uint8_t c2 = (conditions[group] >> 1) & 1;
+        uint8_t c3 = conditions[group] & 1;
+        out[0] |= (!c1 << group) | (!c2 << (4 + group));
+        out[1] |= (!c3 << group) | (c1 << (4 + group));
+        out[2] |= (c2 << group) | (c3 << (4 + group));
+    }
+    out[3] = 0x69;
+}
+
+static void set_default_keys(SectorKeys *keys, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        keys[i].has_key_a = true;
+        memcpy(keys[i].key_a, default_key, 6);
+        keys[i].has_key_b = true;
+        memcpy(keys[i].key_b, default_key, 6);
+    }
+}
+
+TEST(refused_keys_are_tried_once_per_sector)
+{
+    SimClassic card;
+    NFCFramework nfc(new FakePN532(&card));
+    SectorKeys keys[16];
+    const uint8_t wrong[6] = {1, 2, 3, 4, 5, 6};
+    keys[1].has_key_a = true;
+    memcpy(keys[1].key_a, wrong, 6);
+    keys[1].has_key_b = true;
+    memcpy(keys[1].key_b, wrong, 6);
+
+    ValueOperation operations[3];
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        operations[i].type = VALUE_READ;
+        operations[i].block = 4 + i;
+    }
+    CHECK(nfc.value_batch(operations, 3, keys) == 0);
+    CHECK(operations[2].status == VALUE_DENIED);
+    CHECK(card.auths == 2);
+}
+
+TEST(trailer_write_forgets_access_bits)
+{
+    SimClassic card;
+    NFCFramework nfc(new FakePN532(&card));
+    SectorKeys keys[16];
+    set_default_keys(keys, 16);
+    uint8_t block[16];
+    CHECK(nfc.read_block(4, &keys[1], block));
+
+    // Data blocks become Key B only
+    const uint8_t conditions[4] = {0b011, 0b011, 0b011, 0b011};
+    uint8_t trailer[16];
+    memcpy(trailer, default_key, 6);
+    encode_access(conditions, &trailer[6]);
+    memcpy(&trailer[10], default_key, 6);
+    CHECK(nfc.write_tag(7, trailer, &keys[1]));
+    CHECK(nfc.read_block(4, &keys[1], block));
+}
+
+TEST(dump_fills_only_accepted_keys)
+{
+    SimClassic card;
+    const uint8_t key_b[6] = {0xB0, 0xB1, 0xB2, 0xB3, 0xB4, 0xB5};
+    const uint8_t conditions[4] = {0b000, 0b000, 0b000, 0b011};
+    uint8_t access[4];
+    encode_access(conditions, access);
+    card.set_keys(1, default_key, key_b, access);
+    NFCFramework nfc(new FakePN532(&card));
+    SectorKeys keys[16];
+    set_default_keys(keys, 16);  // Key B of sector 1 is wrong and never needed
+
+    DumpPlan plan;
+    DumpResult result;
+    CHECK(nfc.plan_dump(&plan));
+    uint8_t *dump = nfc.dump_tag(&plan, keys, &result);
+    CHECK(dump != NULL);
+    CHECK(result.unreadable == 0 && result.unauthenticated == 0);
+    const uint8_t zero[6] = {0};
+    CHECK(memcmp(&dump[7 * 16], default_key, 6) == 0);
+    CHECK(memcmp(&dump[7 * 16 + 10], zero, 6) == 0);
+    free(dump);
+}
+
+TEST(legacy_trailer_write_forgets_access_bits)
+{
+    SimClassic card;
+    const uint8_t key_b[6] = {0xB0, 0xB1, 0xB2, 0xB3, 0xB4, 0xB5};
+    // Data blocks and trailer writable with Key B only
+    const uint8_t conditions[4] = {0b011, 0b011, 0b011, 0b011};
+    uint8_t access[4];
+    encode_access(conditions, access);
+    card.set_keys(1, default_key, key_b, access);
+    NFCFramework nfc(new FakePN532(&card));
+    SectorKeys keys;
+    keys.has_key_a = true;
+    memcpy(keys.key_a, default_key, 6);
+    uint8_t block[16];
+    // Key A can't read, the framework learns it
+    CHECK(!nfc.read_block(4, &keys, block));
+
+    // Back to transport configuration through the key based overload
+    const uint8_t transport[4] = {0b000, 0b000, 0b000, 0b001};
+    uint8_t trailer[16];
+    memcpy(trailer, default_key, 6);
+    encode_access(transport, &trailer[6]);
+    memcpy(&trailer[10], default_key, 6);
+    CHECK(nfc.write_tag(7, trailer, KEY_B, (uint8_t *)key_b));
+    CHECK(memcmp(&card.blocks[7][6], &trailer[6], 4) == 0);
+    uint32_t auths = card.auths;
+    CHECK(nfc.read_block(4, &keys, block));
+    CHECK(card.auths > auths);
+}
+
+TEST(simulator_masks_trailer_read)
+{
+    SimClassic card;
+    const uint8_t key_b[6] = {0xB0, 0xB1, 0xB2, 0xB3, 0xB4, 0xB5};
+    const uint8_t conditions[4] = {0b000, 0b000, 0b000, 0b011};
+    uint8_t access[4];
+    encode_access(conditions, access);
+    card.set_keys(1, default_key, key_b, access);
+    NFCFramework nfc(new FakePN532(&card));
+    uint8_t block[16];
+    // 011: access bits readable with both keys, Key A and Key B never
+    CHECK(nfc.read_block(7, (uint8_t *)key_b, KEY_B, block));
+    const uint8_t zero[6] = {0};
+    CHECK(memcmp(block, zero, 6) == 0);
+    CHECK(memcmp(&block[6], access, 4) == 0);
+    CHECK(memcmp(&block[10], zero, 6) == 0);
+    // Key A can't write the 011 trailer
+    uint8_t trailer[16] = {0};
+    CHECK(!nfc.write_tag(7, trailer, KEY_A, (uint8_t *)default_key));
+}
@@ -0,0 +1,216 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test.hpp"
+#include "fake_pn532.hpp"
+#include "nfc_framework.hpp"
+
+static const uint8_t default_key[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+static const uint8_t key_b[6] = {0xB0, 0xB1, 0xB2, 0xB3, 0xB4, 0xB5};
+
+// 0x12345678 at address 5 laid out as in the MF1S50 datasheet value block format
+static const uint8_t value_block[16] = {0x78, 0x56, 0x34, 0x12, 0x87, 0xA9, 0xCB, 0xED,
+                                        0x78, 0x56, 0x34, 0x12, 0x05, 0xFA, 0x05, 0xFA};
+
+static void set_keys(SectorKeys *keys, uint8_t count, bool with_key_b)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        keys[i].has_key_a = true;
+        memcpy(keys[i].key_a, default_key, 6);
+        keys[i].has_key_b = with_key_b;
+        memcpy(keys[i].key_b, key_b, 6);
+    }
+}
+
+static void set_value(SimClassic *card, uint8_t block, uint32_t value)
+{
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        card->blocks[block][i] = card->blocks[block][8 + i] = value >> (8 * i);
+        card->blocks[block][4 + i] = ~(value >> (8 * i));
+    }
+    card->blocks[block][12] = card->blocks[block][14] = block;
+    card->blocks[block][13] = card->blocks[block][15] = ~block;
+}
+
+static ValueOperation value_operation(ValueOpType type, uint8_t block, int32_t value = 0, uint8_t transfer_block = 0)
+{
+    ValueOperation operation;
+    operation.type = type;
+    operation.block = block;
+    operation.value = value;
+    operation.transfer_block = transfer_block;
+    return operation;
+}
+
+TEST(value_encode_matches_datasheet_layout)
+{
+    uint8_t block[16];
+    int32_t value;
+    uint8_t address;
+    mifare_value_encode(0x12345678, 5, block);
+    CHECK(memcmp(block, value_block, 16) == 0);
+    CHECK(mifare_value_decode(block, &value, &address));
+    CHECK(value == 0x12345678 && address == 5);
+
+    const int32_t values[] = {0, 1, -1, INT32_MAX, INT32_MIN};
+    for (int32_t expected : values)
+    {
+        mifare_value_encode(expected, 0x3C, block);
+        CHECK(mifare_value_decode(block, &value, &address));
+        CHECK(value == expected && address == 0x3C);
+    }
+}
+
+TEST(value_decode_rejects_broken_blocks)
+{
+    uint8_t block[16];
+    int32_t value;
+    const uint8_t zero[16] = {0};
+    CHECK(!mifare_value_decode(zero, &value, NULL));
+    // Inverted copy, second copy and address copies must all agree
+    const uint8_t broken[] = {4, 9, 12, 13, 14, 15};
+    for (uint8_t byte : broken)
+    {
+        memcpy(block, value_block, 16);
+        block[byte] ^= 0x01;
+        CHECK(!mifare_value_decode(block, &value, NULL));
+    }
+}
+
+TEST(value_set_and_read)
+{
+    SimClassic card;
+    NFCFramework nfc(new FakePN532(&card));
+    SectorKeys keys[16];
+    set_keys(keys, 16, false);
+    ValueOperation operations[2] = {value_operation(VALUE_SET, 5, 0x12345678), value_operation(VALUE_READ, 5)};
+    CHECK(nfc.value_batch(operations, 2, keys) == 2);
+    CHECK(operations[0].status == VALUE_OK && operations[1].status == VALUE_OK);
+    CHECK(memcmp(card.blocks[5], value_block, 16) == 0);
+    CHECK(operations[1].value == 0x12345678);
+}
+
+TEST(value_increment_decrement_restore_transfer)
+{
+    SimClassic card;
+    set_value(&card, 4, 100);
+    NFCFramework nfc(new FakePN532(&card));
+    SectorKeys keys[16];
+    set_keys(keys, 16, false);
+    ValueOperation operations[] = {
+        value_operation(VALUE_INCREMENT, 4, 25, 4),
+        value_operation(VALUE_DECREMENT, 4, 30, 5),
+        value_operation(VALUE_RESTORE, 4, 0, 6),
+        value_operation(VALUE_DECREMENT, 6, 200, 6),
+        value_operation(VALUE_READ, 4),
+        value_operation(VALUE_READ, 5),
+        value_operation(VALUE_READ, 6),
+    };
+    CHECK(nfc.value_batch(operations, 7, keys) == 7);
+    CHECK(card.transfers == 4);
+    CHECK(operations[4].value == 125);
+    CHECK(operations[5].value == 95);
+    CHECK(operations[6].value == -75);
+    // Transfer to a block that wasn't a value block formats it with its own address
+    CHECK(card.blocks[5][12] == 5 && card.blocks[6][12] == 6);
+}
+
+TEST(value_batch_authenticates_once_per_sector)
+{
+    SimClassic card;
+    set_value(&card, 4, 10);
+    set_value(&card, 8, 20);
+    NFCFramework nfc(new FakePN532(&card));
+    SectorKeys keys[16];
+    set_keys(keys, 16, false);
+    ValueOperation operations[] = {
+        value_operation(VALUE_READ, 4),
+        value_operation(VALUE_INCREMENT, 4, 1, 4),
+        value_operation(VALUE_READ, 4),
+        value_operation(VALUE_READ, 8),
+        value_operation(VALUE_DECREMENT, 8, 1, 9),
+        value_operation(VALUE_READ, 9),
+    };
+    CHECK(nfc.value_batch(operations, 6, keys) == 6);
+    CHECK(operations[2].value == 11 && operations[5].value == 19);
+    CHECK(card.auths == 2);
+}
+
+TEST(value_batch_reports_bad_format)
+{
+    SimClassic card;
+    set_value(&card, 4, 10);
+    NFCFramework nfc(new FakePN532(&card));
+    SectorKeys keys[16];
+    set_keys(keys, 16, false);
+    ValueOperation operations[] = {
+        value_operation(VALUE_READ, 1),                 // Plain data block
+        value_operation(VALUE_SET, 7, 1),               // Sector trailer
+        value_operation(VALUE_INCREMENT, 4, 1, 8),      // Transfer to another sector
+        value_operation(VALUE_RESTORE, 4, 0, 7),        // Transfer to the trailer
+        value_operation(VALUE_READ, 64),                // Past the card
+    };
+    CHECK(nfc.value_batch(operations, 5, keys) == 0);
+    for (const ValueOperation &operation : operations)
+        CHECK(operation.status == VALUE_BAD_FORMAT);
+    CHECK(card.transfers == 0);
+}
+
+TEST(value_batch_reports_denied_and_failed)
+{
+    SimClassic card;
+    // Sector 1: data blocks 110(increment with Key B only), trailer 011(Key B can authenticate)
+    const uint8_t access[4] = {0x08, 0x77, 0x8F, 0x69};
+    card.set_keys(1, default_key, key_b, access);
+    set_value(&card, 4, 50);
+    NFCFramework nfc(new FakePN532(&card));
+    SectorKeys keys[16];
+    set_keys(keys, 16, false);
+    ValueOperation operations[] = {
+        value_operation(VALUE_INCREMENT, 4, 1, 4),  // Needs Key B
+        value_operation(VALUE_SET, 5, 1),           // Write needs Key B
+        value_operation(VALUE_DECREMENT, 4, 5, 4),  // Key A is enough
+        value_operation(VALUE_INCREMENT, 1, 1, 1),  // Sector 0 allows it but block 1 isn't a value block
+        value_operation(VALUE_READ, 4),             // Runs after the card is selected again
+    };
+    CHECK(nfc.value_batch(operations, 5, keys) == 2);
+    CHECK(operations[0].status == VALUE_DENIED);
+    CHECK(operations[1].status == VALUE_DENIED);
+    CHECK(operations[2].status == VALUE_OK);
+    CHECK(operations[3].status == VALUE_FAILED);
+    CHECK(operations[4].status == VALUE_OK && operations[4].value == 45);
+
+    // With Key B the increment goes through
+    set_keys(keys, 16, true);
+    ValueOperation increment = value_operation(VALUE_INCREMENT, 4, 10, 4);
+    CHECK(nfc.value_batch(&increment, 1, keys) == 1);
+    ValueOperation read = value_operation(VALUE_READ, 4);
+    CHECK(nfc.value_batch(&read, 1, keys) == 1);
+    CHECK(read.value == 55);
+}
+
+TEST(value_batch_needs_classic_card)
+{
+    SimType2 card(16);
+    NFCFramework nfc(new FakePN532(&card));
+    SectorKeys keys[16];
+    ValueOperation operation = value_operation(VALUE_READ, 4);
+    CHECK(nfc.value_batch(&operation, 1, keys) == -1);
+    CHECK(operation.status == VALUE_NOT_RUN);
+}
@@ -0,0 +1,128 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "test.hpp"
+#include "fake_pn532.hpp"
+#include "nfc_framework.hpp"
+
+// Capability container of a NTAG216, 872 bytes of NDEF area
+static void format_ntag216(SimType2 *card)
+{
+    const uint8_t cc[4] = {0xE1, 0x10, 0x6D, 0x00};
+    memcpy(&card->memory[NDEF_CC_PAGE * 4], cc, 4);
+}
+
+TEST(ndef_parser_rejects_huge_payload_length)
+{
+    // Long record, type length 1, payload length 0xFFFFFFFE
+    const uint8_t message[] = {NDEF_MB | NDEF_ME | NDEF_TNF_WELL_KNOWN, 0x01, 0xFF, 0xFF, 0xFF, 0xFE, 'T', 0x00};
+    NDEFParser parser(message, sizeof(message));
+    NDEFRecord record;
+    CHECK(!parser.next(&record));
+}
+
+TEST(ndef_parser_rejects_chunked_records)
+{
+    const uint8_t message[] = {NDEF_MB | NDEF_CF | NDEF_SR | NDEF_TNF_MIME, 0x01, 0x01, 'a', 'b'};
+    NDEFParser parser(message, sizeof(message));
+    NDEFRecord record;
+    CHECK(!parser.next(&record));
+}
+
+TEST(ndef_write_sets_length_last)
+{
+    SimType2 card(231);
+    format_ntag216(&card);
+    NFCFramework nfc(new FakePN532(&card));
+    uint8_t payload[300];
+    for (size_t i = 0; i < sizeof(payload); i++)
+        payload[i] = i;
+    NDEFRecord record;
+    record.tnf = NDEF_TNF_MIME;
+    record.type = (const uint8_t *)"a/b";
+    record.type_length = 3;
+    record.payload = payload;
+    record.payload_length = sizeof(payload);
+    CHECK(nfc.ndef_write(&record, 1));
+
+    // First page goes twice, the first time with an empty message
+    CHECK(card.written_pages.size() >= 3);
+    CHECK(card.written_pages.front() == NDEF_DATA_PAGE);
+    CHECK(card.written_pages.back() == NDEF_DATA_PAGE);
+
+    uint8_t message[512];
+    int length = nfc.ndef_read(message, sizeof(message));
+    CHECK(length > 0);
+    NDEFParser parser(message, length);
+    NDEFRecord parsed;
+    CHECK(parser.next(&parsed));
+    CHECK(parsed.payload_length == sizeof(payload));
+    CHECK(memcmp(parsed.payload, payload, sizeof(payload)) == 0);
+    CHECK(!parser.next(&parsed));
+}
+
+TEST(ndef_write_stays_within_addressable_pages)
+{
+    // The CC claims 2032 bytes, past the 256 pages a WRITE can address
+    SimType2 card(600);
+    const uint8_t cc[4] = {0xE1, 0x10, 0xFE, 0x00};
+    memcpy(&card.memory[NDEF_CC_PAGE * 4], cc, 4);
+    NFCFramework nfc(new FakePN532(&card));
+    static uint8_t payload[1100];
+    NDEFRecord record;
+    record.tnf = NDEF_TNF_MIME;
+    record.type = (const uint8_t *)"a/b";
+    record.type_length = 3;
+    record.payload = payload;
+    record.payload_length = sizeof(payload);
+    CHECK(!nfc.ndef_write(&record, 1));
+    CHECK(card.writes == 0);
+}
+
+TEST(ndef_write_keeps_lock_control_tlv)
+{
+    // Ultralight C: 144 bytes of NDEF area starting with a Lock Control TLV
+    SimType2 card(48);
+    const uint8_t cc[4] = {0xE1, 0x10, 0x12, 0x00};
+    const uint8_t data[8] = {NDEF_TLV_LOCK_CONTROL, 0x03, 0xA0, 0x10, 0x44, NDEF_TLV_MESSAGE, 0x00, NDEF_TLV_TERMINATOR};
+    memcpy(&card.memory[NDEF_CC_PAGE * 4], cc, 4);
+    memcpy(&card.memory[NDEF_DATA_PAGE * 4], data, sizeof(data));
+    NFCFramework nfc(new FakePN532(&card));
+    const uint8_t payload[] = {0x02, 'e', 'n', 'h', 'i'};
+    NDEFRecord record;
+    record.tnf = NDEF_TNF_WELL_KNOWN;
+    record.type = (const uint8_t *)"T";
+    record.type_length = 1;
+    record.payload = payload;
+    record.payload_length = sizeof(payload);
+    CHECK(nfc.ndef_write(&record, 1));
+
+    CHECK(memcmp(&card.memory[NDEF_DATA_PAGE * 4], data, 5) == 0);
+    CHECK(card.memory[NDEF_DATA_PAGE * 4 + 5] == NDEF_TLV_MESSAGE);
+    CHECK(card.written_pages.front() == NDEF_DATA_PAGE + 1);
+    CHECK(card.written_pages.back() == NDEF_DATA_PAGE + 1);
+
+    uint8_t message[64];
+    int length = nfc.ndef_read(message, sizeof(message));
+    CHECK(length > 0);
+    NDEFParser parser(message, length);
+    NDEFRecord parsed;
+    CHECK(parser.next(&parsed));
+    CHECK(parsed.payload_length == sizeof(payload));
+    CHECK(memcmp(parsed.payload, payload, sizeof(payload)) == 0);
+}
@@ -0,0 +1,125 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "test.hpp"
+#include "fake_pn532.hpp"
+#include "nfc_framework.hpp"
+
+static PresenceConfig presence_types(uint8_t type)
+{
+    PresenceConfig config;
+    config.types[0] = type;
+    return config;
+}
+
+TEST(presence_reads_type_b_pupi)
+{
+    FakePN532 *pn532 = new FakePN532();
+    NFCFramework nfc(pn532);
+    // Tg, ATQB(0x50, PUPI, application data, protocol info), ATTRIB_RES length
+    pn532->autopoll.push_back({1, AUTOPOLL_ISO14443_4B, 14, 1, 0x50, 0xA1, 0xA2, 0xA3, 0xA4, 0, 0, 0, 0, 0x80, 0x81, 0x71, 0});
+    nfc.presence_begin(presence_types(AUTOPOLL_ISO14443_4B));
+    PresenceEvent event;
+    CHECK(nfc.presence_poll(&event));
+    CHECK(event.type == PRESENCE_ARRIVED);
+    CHECK(event.uid_length == 4);
+    const uint8_t pupi[] = {0xA1, 0xA2, 0xA3, 0xA4};
+    CHECK(memcmp(event.uid, pupi, 4) == 0);
+}
+
+TEST(presence_reads_jewel_and_felica_ids)
+{
+    FakePN532 *pn532 = new FakePN532();
+    NFCFramework nfc(pn532);
+    // Tg, SENS_RES, JEWELID
+    pn532->autopoll.push_back({1, AUTOPOLL_JEWEL, 7, 1, 0x0C, 0x00, 0x11, 0x22, 0x33, 0x44});
+    // Tg, POL_RES length, response code, IDm, PMm
+    pn532->autopoll.push_back({1, AUTOPOLL_GENERIC_FELICA_212, 19, 1, 18, 0x01, 1, 2, 3, 4, 5, 6, 7, 8, 0, 0, 0, 0, 0, 0, 0, 0});
+    nfc.presence_begin(presence_types(AUTOPOLL_JEWEL));
+    PresenceEvent event;
+    CHECK(nfc.presence_poll(&event));
+    CHECK(event.type == PRESENCE_ARRIVED && event.uid_length == 4 && event.uid[0] == 0x11);
+    CHECK(nfc.presence_poll(&event));
+    CHECK(event.type == PRESENCE_REMOVED);
+    CHECK(nfc.presence_poll(&event));
+    CHECK(event.type == PRESENCE_ARRIVED && event.uid_length == 8 && event.uid[0] == 1 && event.uid[7] == 8);
+}
+
+TEST(presence_ignores_short_target)
+{
+    FakePN532 *pn532 = new FakePN532();
+    NFCFramework nfc(pn532);
+    // NFCID1 length says 7 bytes, none follows
+    pn532->autopoll.push_back({1, AUTOPOLL_MIFARE, 5, 1, 0x00, 0x44, 0x00, 0x07});
+    nfc.presence_begin(presence_types(AUTOPOLL_MIFARE));
+    PresenceEvent event;
+    CHECK(!nfc.presence_poll(&event));
+    CHECK(event.type == PRESENCE_NONE);
+}
+
+TEST(power_down_needs_irq)
+{
+    FakePN532 *pn532 = new FakePN532();
+    NFCFramework nfc(pn532);
+    PresenceConfig config;
+    config.power_down = true;
+    nfc.presence_begin(config);
+    PresenceEvent event;
+    CHECK(!nfc.presence_poll(&event));
+    CHECK(!pn532->asleep);
+    CHECK(pn532->count(PN532_COMMAND_POWERDOWN) == 0);
+}
+
+TEST(power_down_wakes_on_demand)
+{
+    FakePN532 *pn532 = new FakePN532();
+    NFCFramework nfc(pn532);
+    CHECK(nfc.power_down(WAKEUP_RF));
+    CHECK(pn532->asleep);
+    CHECK(pn532->wakeup_sources & WAKEUP_RF);
+    // Already sleeping, nothing to send
+    CHECK(nfc.power_down(WAKEUP_RF));
+    CHECK(pn532->count(PN532_COMMAND_POWERDOWN) == 1);
+    // Any call brings it back
+    CHECK(nfc.get_version() != 0);
+    CHECK(!pn532->asleep);
+    CHECK(nfc.power_down());
+    CHECK(pn532->asleep);
+    uint8_t cmd[] = {PN532_COMMAND_GETFIRMWAREVERSION};
+    uint8_t response[4];
+    CHECK(nfc.pn532_command(cmd, sizeof(cmd), response, sizeof(response)) == 4);
+    CHECK(!pn532->asleep);
+}
+
+TEST(power_down_sleeps_on_irq)
+{
+    FakePN532 *pn532 = new FakePN532();
+    NFCFramework nfc(pn532);
+    pn532->set_irq(5);
+    PresenceConfig config;
+    config.power_down = true;
+    nfc.presence_begin(config);
+    PresenceEvent event;
+    CHECK(!nfc.presence_poll(&event));
+    CHECK(pn532->asleep);
+    pn532->rf_field = true;
+    pn532->autopoll.push_back({1, AUTOPOLL_MIFARE, 9, 1, 0x00, 0x04, 0x08, 0x04, 0xDE, 0xAD, 0xBE, 0xEF});
+    CHECK(nfc.presence_poll(&event));
+    CHECK(pn532->wakeup_waits == 1);
+    CHECK(event.type == PRESENCE_ARRIVED && event.uid_length == 4);
+}
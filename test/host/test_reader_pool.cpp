@@ -0,0 +1,105 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test.hpp"
+#include "fake_pn532.hpp"
+#include "nfc_reader_pool.hpp"
+#include <memory>
+#include <stdexcept>
+
+#define POOL_SCANS 32
+#define POOL_LATENCY_US 10000   // RF and PN532 time of one InListPassiveTarget
+
+static bool rejected(std::future<ScanResult> &future)
+{
+    try
+    {
+        future.get();
+    }
+    catch (const std::runtime_error &)
+    {
+        return true;
+    }
+    return false;
+}
+
+TEST(pool_rejects_jobs_nobody_serves)
+{
+    SimClassic card;
+    NFCFramework reader(new FakePN532(&card));
+    NFCReaderPool empty;
+    empty.start();
+    std::future<ScanResult> no_readers = empty.submit_scan();
+    empty.wait_all();
+    CHECK(rejected(no_readers));
+
+    NFCReaderPool pool;
+    pool.add_reader(&reader);
+    std::future<ScanResult> before_start = pool.submit_scan();
+    CHECK(rejected(before_start));
+    pool.start();
+    std::future<ScanResult> served = pool.submit_scan();
+    CHECK(served.get().found);
+    pool.stop();
+    std::future<ScanResult> after_stop = pool.submit_scan();
+    pool.wait_all();
+    CHECK(rejected(after_stop));
+}
+
+/* Seconds to serve POOL_SCANS scans with readers PN532 on the same bus */
+static double pool_scan_time(size_t readers, size_t *found)
+{
+    std::vector<std::unique_ptr<SimClassic>> cards;
+    std::vector<std::unique_ptr<NFCFramework>> frameworks;
+    std::mutex bus;
+    NFCReaderPool pool;
+    for (size_t i = 0; i < readers; i++)
+    {
+        cards.emplace_back(new SimClassic());
+        FakePN532 *pn532 = new FakePN532(cards.back().get());
+        pn532->latency_us = POOL_LATENCY_US;
+        frameworks.emplace_back(new NFCFramework(pn532));
+        pool.add_reader(frameworks.back().get(), &bus);
+    }
+
+    pool.start();
+    unsigned long start = micros();
+    std::vector<std::future<ScanResult>> scans;
+    for (size_t i = 0; i < POOL_SCANS; i++)
+        scans.push_back(pool.submit_scan());
+    pool.wait_all();
+    unsigned long elapsed = micros() - start;
+    pool.stop();
+
+    *found = 0;
+    for (std::future<ScanResult> &scan : scans)
+        *found += scan.get().found;
+    return elapsed / 1e6;
+}
+
+TEST(pool_throughput_scales_with_readers)
+{
+    size_t found;
+    FakePN532::bus_overlaps = 0;
+    double one = pool_scan_time(1, &found);
+    CHECK(found == POOL_SCANS);
+    double four = pool_scan_time(4, &found);
+    CHECK(found == POOL_SCANS);
+    printf("     1 reader %.0f scans/s, 4 readers %.0f scans/s\n", POOL_SCANS / one, POOL_SCANS / four);
+    CHECK(one / four > 3.0);
+    CHECK(FakePN532::bus_overlaps == 0);
+}
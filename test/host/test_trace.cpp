@@ -0,0 +1,76 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test.hpp"
+#include "fake_pn532.hpp"
+#include "memory_stream.hpp"
+#include "nfc_framework.hpp"
+
+TEST(trace_ring_drops_what_does_not_fit)
+{
+    NFCTrace trace(32);
+    uint8_t data[20] = {0};
+    MemoryStream out;
+
+    trace.record(TRACE_COMMAND, data, 20);
+    trace.record(TRACE_RESPONSE, data, 20);
+    CHECK(trace.get_dropped() == 1);
+    trace.dump(&out);
+    CHECK(out.data.size() == TRACE_HEADER_SIZE + TRACE_RECORD_HEADER_SIZE + 20);
+    CHECK(memcmp(out.data.data(), TRACE_MAGIC, 4) == 0);
+
+    /* Dumped space is free again, the second dump has no header */
+    trace.record(TRACE_RESPONSE, data, 20);
+    trace.dump(&out);
+    CHECK(out.data.size() == TRACE_HEADER_SIZE + 2 * (TRACE_RECORD_HEADER_SIZE + 20));
+}
+
+TEST(trace_replay_reproduces_ntag_dump)
+{
+    SimType2 card(45);
+    card.has_version = true;
+    uint8_t version[8] = {0x00, 0x04, 0x04, 0x02, 0x01, 0x00, 0x0F, 0x03};
+    memcpy(card.version, version, 8);
+    for (size_t i = 16; i < card.memory.size(); i++)
+        card.memory[i] = i;
+
+    /* Record a session on the simulated PN532 */
+    NFCTrace trace(8192);
+    NFCFramework recorder(new FakePN532(&card));
+    recorder.set_trace(&trace);
+    DumpPlan plan;
+    DumpResult result;
+    CHECK(recorder.plan_dump(&plan));
+    uint8_t *recorded = recorder.dump_tag(&plan, (Key *)NULL, &result);
+    CHECK(recorded != NULL);
+    MemoryStream capture;
+    trace.dump(&capture);
+
+    /* Same calls on the replayed trace give the same dump without a card */
+    PN532Replay *replay = new PN532Replay(capture.data.data(), capture.data.size());
+    NFCFramework replayed(replay);
+    DumpPlan replay_plan;
+    CHECK(replayed.plan_dump(&replay_plan));
+    CHECK(strcmp(replay_plan.name, "NTAG213") == 0);
+    uint8_t *dump = replayed.dump_tag(&replay_plan, (Key *)NULL, &result);
+    CHECK(dump != NULL);
+    CHECK(memcmp(dump, recorded, dump_plan_image_size(&plan)) == 0);
+    CHECK(replay->get_mismatches() == 0);
+    CHECK(replay->finished());
+    free(recorded);
+    free(dump);
+}
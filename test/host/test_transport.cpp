@@ -0,0 +1,82 @@
+/*
+ * This file is part of the Capibara zero project(https://capibarazero.github.io/).
+ * Copyright (c) 2025 Andrea Canale.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test.hpp"
+#include "pn532_transport.hpp"
+#include <vector>
+
+static const uint8_t ack[] = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
+
+// PN532 host interface reading frames from a script
+class FramePN532 : public PN532Transport
+{
+protected:
+    bool is_ready() { return !replies.empty(); };
+    void write_frame(const uint8_t *data, size_t len) { written.push_back(std::vector<uint8_t>(data, data + len)); };
+    int16_t read_frame(uint8_t *data, size_t max_len) {
+        if (replies.empty() || replies.front().size() > max_len)
+            return -1;
+        std::vector<uint8_t> reply = replies.front();
+        replies.erase(replies.begin());
+        memcpy(data, reply.data(), reply.size());
+        return reply.size();
+    };
+public:
+    std::vector<std::vector<uint8_t>> replies;
+    std::vector<std::vector<uint8_t>> written;
+    void begin() {};
+    void wakeup() {};
+};
+
+TEST(transport_aborts_command_on_timeout)
+{
+    FramePN532 pn532;
+    uint8_t cmd[] = {0x4A, 0x01, 0x00};
+    uint8_t response[16];
+    pn532.replies.push_back(std::vector<uint8_t>(ack, ack + sizeof(ack)));
+
+    CHECK(pn532.command(cmd, sizeof(cmd), response, sizeof(response), 5) == -2);
+    CHECK(pn532.written.size() == 2);
+    CHECK(pn532.written[1] == std::vector<uint8_t>(ack, ack + sizeof(ack)));
+}
+
+TEST(transport_rejects_frame_without_response_code)
+{
+    FramePN532 pn532;
+    uint8_t cmd[] = {0x02};
+    uint8_t response[16];
+    /* LEN 1 holds only the TFI */
+    uint8_t frame[] = {0x00, 0x00, 0xFF, 0x01, 0xFF, 0xD5, 0x2B, 0x00};
+    pn532.replies.push_back(std::vector<uint8_t>(ack, ack + sizeof(ack)));
+    pn532.replies.push_back(std::vector<uint8_t>(frame, frame + sizeof(frame)));
+
+    CHECK(pn532.command(cmd, sizeof(cmd), response, sizeof(response)) == -3);
+}
+
+TEST(transport_parses_response)
+{
+    FramePN532 pn532;
+    uint8_t cmd[] = {0x02};
+    uint8_t response[16];
+    uint8_t frame[] = {0x00, 0x00, 0xFF, 0x06, 0xFA, 0xD5, 0x03, 0x32, 0x01, 0x06, 0x07, 0xE8, 0x00};
+    pn532.replies.push_back(std::vector<uint8_t>(ack, ack + sizeof(ack)));
+    pn532.replies.push_back(std::vector<uint8_t>(frame, frame + sizeof(frame)));
+
+    CHECK(pn532.command(cmd, sizeof(cmd), response, sizeof(response)) == 4);
+    CHECK(response[0] == 0x32 && response[3] == 0x07);
+    CHECK(pn532.written.size() == 1);
+}